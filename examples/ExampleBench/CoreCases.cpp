@@ -0,0 +1,148 @@
+#include "ExampleBench.h"
+
+// Cases from the Core examples. Each setup function builds its data once; the returned
+// body is what is timed.
+
+// MySerializationExample.cpp
+struct BenchObject : Moveable<BenchObject> {
+    String name;
+    int    value = 0;
+
+    void Serialize(Stream& s) { s % name % value; }
+};
+
+// MyColorValueExample.cpp, without the Convert and Display
+struct MyColorValue {
+    Color  colorVal;
+    String name;
+
+    MyColorValue() : colorVal(Black()) {}
+    MyColorValue(Color c, String n) : colorVal(c), name(n) {}
+};
+
+static Vector<String> Keys(int n, const char *prefix)
+{
+    Vector<String> k;
+    for(int i = 0; i < n; i++)
+        k.Add(Format("%s%d", prefix, i));
+    return k;
+}
+
+INITBLOCK {
+    // MyCoPartitionExample.cpp, with a 64-bit sum
+    RegisterBench("CoPartition", "sum 1M ints", 1000000, [] {
+        auto numbers = std::make_shared<Vector<int>>();
+        for(int i = 0; i < 1000000; i++)
+            numbers->Add(i % 1000);
+        return [=] {
+            std::atomic<int64> total(0);
+            CoPartition(*numbers, [&](const SubRange<const Vector<int>>& subrange) {
+                int64 sum = 0;
+                for(int x : subrange)
+                    sum += x;
+                total += sum;
+            });
+            BenchKeep(total);
+        };
+    });
+
+    RegisterBench("Serialization", "StoreAsString/LoadFromString object", 1, [] {
+        auto object = std::make_shared<BenchObject>();
+        object->name = "TestObject";
+        object->value = 123;
+        return [=] {
+            BenchObject loaded;
+            LoadFromString(loaded, StoreAsString(*object));
+            BenchKeep(loaded.value);
+        };
+    });
+
+    RegisterBench("Serialization", "StoreAsString/LoadFromString 10K vector", 10000, [] {
+        auto data = std::make_shared<Vector<BenchObject>>();
+        for(int i = 0; i < 10000; i++) {
+            BenchObject& o = data->Add();
+            o.name = Format("object %d", i);
+            o.value = i;
+        }
+        return [=] {
+            Vector<BenchObject> loaded;
+            LoadFromString(loaded, StoreAsString(*data));
+            BenchKeep(loaded.GetCount());
+        };
+    });
+
+    RegisterBench("Value", "RawToValue MyColorValue box", 1000, [] {
+        return [] {
+            for(int i = 0; i < 1000; i++) {
+                Value v = RawToValue(MyColorValue(Color(i & 255, 0, 0), "Red"));
+                BenchKeep(v.Is<MyColorValue>());
+            }
+        };
+    });
+
+    RegisterBench("Value", "MyColorValue copy/Is/Get", 1000, [] {
+        auto values = std::make_shared<Vector<Value>>();
+        for(int i = 0; i < 1000; i++)
+            values->Add(RawToValue(MyColorValue(Color(i & 255, 0, 0), "Red")));
+        return [=] {
+            int64 sum = 0;
+            for(const Value& q : *values) {
+                Value v = q;
+                if(v.Is<MyColorValue>())
+                    sum += v.Get<MyColorValue>().colorVal.GetR();
+            }
+            BenchKeep(sum);
+        };
+    });
+
+    // The guide's container section
+    RegisterBench("Containers", "Index<String> Find hit 100K", 100000, [] {
+        auto keys = std::make_shared<Vector<String>>(Keys(100000, "k"));
+        auto index = std::make_shared<Index<String>>();
+        for(const String& k : *keys)
+            index->Add(k);
+        return [=] {
+            int64 sum = 0;
+            for(const String& k : *keys)
+                sum += index->Find(k);
+            BenchKeep(sum);
+        };
+    });
+
+    RegisterBench("Containers", "Index<String> Find miss 100K", 100000, [] {
+        auto keys = std::make_shared<Vector<String>>(Keys(100000, "k"));
+        auto missing = std::make_shared<Vector<String>>(Keys(100000, "m"));
+        auto index = std::make_shared<Index<String>>();
+        for(const String& k : *keys)
+            index->Add(k);
+        return [=] {
+            int64 sum = 0;
+            for(const String& k : *missing)
+                sum += index->Find(k);
+            BenchKeep(sum);
+        };
+    });
+
+    RegisterBench("Containers", "VectorMap<String,int> Get 100K", 100000, [] {
+        auto keys = std::make_shared<Vector<String>>(Keys(100000, "k"));
+        auto map = std::make_shared<VectorMap<String, int>>();
+        for(int i = 0; i < keys->GetCount(); i++)
+            map->Add((*keys)[i], i);
+        return [=] {
+            int64 sum = 0;
+            for(const String& k : *keys)
+                sum += map->Get(k);
+            BenchKeep(sum);
+        };
+    });
+
+    RegisterBench("Containers", "VectorMap<String,int> build 100K", 100000, [] {
+        auto keys = std::make_shared<Vector<String>>(Keys(100000, "k"));
+        return [=] {
+            VectorMap<String, int> map;
+            for(int i = 0; i < keys->GetCount(); i++)
+                map.Add((*keys)[i], i);
+            BenchKeep(map.GetCount());
+        };
+    });
+}
@@ -0,0 +1,51 @@
+#ifndef _ExampleBench_ExampleBench_h_
+#define _ExampleBench_ExampleBench_h_
+
+#include <Core/Core.h>
+
+using namespace Upp;
+
+// Benchmark harness for the examples' hot paths.
+//
+// A case is registered with a setup function that prepares its data once and returns the
+// body to be measured. The harness calibrates how many calls make up one repetition
+// (at least --min-ms, 20 ms by default), runs --warmup repetitions that are discarded and
+// then --reps measured ones, and reports the time per item (a case says how many items
+// one call processes) as median, MAD (median absolute deviation), p99 and minimum.
+//
+//  ExampleBench [--filter=text] [--reps=15] [--warmup=3] [--min-ms=20]
+//               [--json=file] [--compare=file]
+//
+// --json writes the results and the environment notes, --compare prints the ratio
+// against such a file, which is how a build is checked against a stored baseline.
+// The GUI configuration adds the CtrlLib cases; no window is ever opened.
+
+typedef Function<void ()> BenchBody;
+
+struct BenchCase : Moveable<BenchCase> {
+    String                 group;
+    String                 name;
+    int64                  items = 1;     // items processed by one call of the body
+    Function<BenchBody ()> setup;
+};
+
+struct BenchResult : Moveable<BenchResult> {
+    String group;
+    String name;
+    int64  items = 1;
+    int    calls = 0;              // calls of the body per repetition
+    int    reps = 0;
+    double median = 0;             // ns per item
+    double mad = 0;
+    double p99 = 0;
+    double min = 0;
+};
+
+void RegisterBench(const char *group, const char *name, int64 items, Function<BenchBody ()> setup);
+
+// Keeps the compiler from optimising a benchmarked result away
+void BenchKeep(int64 x);
+
+int  RunBenchmarks(const Vector<String>& args);
+
+#endif
@@ -0,0 +1,40 @@
+#include "ExampleBench.h"
+
+#ifdef flagGUI
+
+#include <CtrlLib/CtrlLib.h>
+
+// MyArrayCtrlExample.cpp population, headless: the ArrayCtrl is never opened, so this
+// measures the cost of Add/Set and of the Value boxing per cell, not painting.
+
+INITBLOCK {
+    RegisterBench("ArrayCtrl", "Add 10K rows (id, name)", 10000, [] {
+        auto names = std::make_shared<Vector<String>>();
+        for(int i = 0; i < 10000; i++)
+            names->Add(Format("Name %d", i));
+        return [=] {
+            ArrayCtrl list;
+            list.AddColumn("ID");
+            list.AddColumn("Name");
+            for(int i = 0; i < names->GetCount(); i++)
+                list.Add(i, (*names)[i]);
+            BenchKeep(list.GetCount());
+        };
+    });
+
+    RegisterBench("ArrayCtrl", "SetCount + Set 10K rows", 10000, [] {
+        return [] {
+            ArrayCtrl list;
+            list.AddColumn("ID");
+            list.AddColumn("Value");
+            list.SetCount(10000);
+            for(int i = 0; i < 10000; i++) {
+                list.Set(i, 0, i);
+                list.Set(i, 1, i * 0.5);
+            }
+            BenchKeep(list.GetCount());
+        };
+    });
+}
+
+#endif
@@ -0,0 +1,235 @@
+#include "ExampleBench.h"
+
+#ifdef PLATFORM_LINUX
+#include <sched.h>
+#endif
+
+static Array<BenchCase>& Cases() { return Single<Array<BenchCase>>(); }
+
+void RegisterBench(const char *group, const char *name, int64 items, Function<BenchBody ()> setup)
+{
+    BenchCase& c = Cases().Add();
+    c.group = group;
+    c.name = name;
+    c.items = max<int64>(items, 1);
+    c.setup = pick(setup);
+}
+
+static std::atomic<int64> bench_sink;
+
+void BenchKeep(int64 x)
+{
+    bench_sink.store(bench_sink.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+}
+
+static String Option(const Vector<String>& args, const char *name, const char *def = "")
+{
+    String prefix = String(name) + "=";
+    for(const String& a : args)
+        if(a.StartsWith(prefix))
+            return a.Mid(prefix.GetCount());
+    return def;
+}
+
+static double Median(const Vector<double>& sorted)
+{
+    int n = sorted.GetCount();
+    return n ? (n & 1 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2) : 0;
+}
+
+static BenchResult Measure(BenchCase& c, int warmup, int reps, int64 min_us)
+{
+    BenchResult r;
+    r.group = c.group;
+    r.name = c.name;
+    r.items = c.items;
+    r.reps = reps;
+
+    BenchBody body = c.setup();
+
+    // Calls per repetition so that one repetition takes at least min_us
+    int calls = 1;
+    for(;;) {
+        int64 t0 = usecs();
+        for(int i = 0; i < calls; i++)
+            body();
+        int64 t = usecs(t0);
+        if(t >= min_us || calls >= INT_MAX / 4)
+            break;
+        calls = t > 0 ? (int)min<int64>(max<int64>(2 * calls, calls * min_us * 11 / (10 * t)), INT_MAX / 4)
+                      : 10 * calls;
+    }
+    r.calls = calls;
+
+    Vector<double> sample;
+    for(int rep = -warmup; rep < reps; rep++) {
+        int64 t0 = usecs();
+        for(int i = 0; i < calls; i++)
+            body();
+        int64 t = usecs(t0);
+        if(rep >= 0)
+            sample.Add(t * 1000.0 / ((double)calls * c.items));
+    }
+    Sort(sample);
+    r.median = Median(sample);
+    r.min = sample[0];
+    r.p99 = sample[min(sample.GetCount() - 1, (sample.GetCount() * 99 + 99) / 100 - 1)];
+    Vector<double> dev;
+    for(double x : sample)
+        dev.Add(fabs(x - r.median));
+    Sort(dev);
+    r.mad = Median(dev);
+    return r;
+}
+
+// Things that make numbers incomparable between runs: clock scaling, affinity, debug code
+static Vector<String> EnvironmentNotes(ValueMap& env)
+{
+    Vector<String> note;
+    env.Add("cores", CPU_Cores());
+#ifdef _DEBUG
+    env.Add("debug", true);
+    note.Add("debug build, timings are not representative");
+#else
+    env.Add("debug", false);
+#endif
+
+#ifdef PLATFORM_LINUX
+    String governor = TrimBoth(LoadFile("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor"));
+    int cur = ScanInt(LoadFile("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq"));
+    int mx = ScanInt(LoadFile("/sys/devices/system/cpu/cpu0/cpufreq/cpuinfo_max_freq"));
+    String no_turbo = TrimBoth(LoadFile("/sys/devices/system/cpu/intel_pstate/no_turbo"));
+    if(governor.GetCount()) {
+        env.Add("governor", governor);
+        if(governor != "performance")
+            note.Add("cpufreq governor is '" + governor + "', clock speed can change during the run");
+    }
+    else
+        note.Add("cpufreq information not available (virtual machine?)");
+    if(!IsNull(cur) && !IsNull(mx) && mx > 0) {
+        env.Add("cpu0_mhz", cur / 1000);
+        env.Add("cpu0_max_mhz", mx / 1000);
+        if(cur < mx * 9 / 10)
+            note.Add(Format("cpu0 runs at %d of %d MHz", cur / 1000, mx / 1000));
+    }
+    if(no_turbo == "0")
+        note.Add("turbo boost is enabled, single-thread results depend on thermal state");
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if(sched_getaffinity(0, sizeof(set), &set) == 0) {
+        int n = CPU_COUNT(&set);
+        env.Add("affinity_cpus", n);
+        if(n < CPU_Cores())
+            note.Add(Format("process is restricted to %d of %d cpus", n, CPU_Cores()));
+    }
+#endif
+
+#ifdef PLATFORM_WIN32
+    DWORD_PTR proc, sys;
+    if(GetProcessAffinityMask(GetCurrentProcess(), &proc, &sys)) {
+        int n = 0;
+        for(DWORD_PTR m = proc; m; m &= m - 1)
+            n++;
+        env.Add("affinity_cpus", n);
+        if(proc != sys)
+            note.Add(Format("process is restricted to %d cpus", n));
+    }
+    note.Add("check the power plan, 'Balanced' lets the clock speed change during the run");
+#endif
+    return note;
+}
+
+static String Key(const String& group, const String& name) { return group + "/" + name; }
+
+// Prints current / baseline for every case found in a previous --json output;
+// returns the number of cases that became slower by more than 10% and 3 MADs
+static int Compare(const Vector<BenchResult>& result, const String& path)
+{
+    Value base = ParseJSON(LoadFile(path));
+    if(base.IsError() || IsNull(base)) {
+        RLOG("Cannot read baseline " << path);
+        return 0;
+    }
+    VectorMap<String, ValueMap> prev;
+    ValueArray va = base["results"];
+    for(int i = 0; i < va.GetCount(); i++) {
+        ValueMap m = va[i];
+        prev.Add(Key(m["group"], m["name"]), m);
+    }
+    RLOG("Compared with " << path);
+    int slower = 0;
+    for(const BenchResult& r : result) {
+        int q = prev.Find(Key(r.group, r.name));
+        if(q < 0)
+            continue;
+        double median = prev[q]["median_ns"];
+        double mad = prev[q]["mad_ns"];
+        double ratio = median > 0 ? r.median / median : 0;
+        bool regression = ratio > 1.1 && r.median - median > 3 * max(mad, r.mad);
+        slower += regression;
+        RLOG(Format("  %-44s %6.2fx%s", Key(r.group, r.name), ratio, regression ? "  SLOWER" : ""));
+    }
+    return slower;
+}
+
+int RunBenchmarks(const Vector<String>& args)
+{
+    String filter = Option(args, "--filter");
+    int reps = max(1, ScanInt(Option(args, "--reps", "15")));
+    int warmup = max(0, ScanInt(Option(args, "--warmup", "3")));
+    int64 min_us = 1000 * max(1, ScanInt(Option(args, "--min-ms", "20")));
+
+    ValueMap env;
+    Vector<String> note = EnvironmentNotes(env);
+    for(const String& s : note)
+        RLOG("note: " << s);
+
+    StableSort(Cases(), [](const BenchCase& a, const BenchCase& b) { return a.group < b.group; });
+
+    RLOG(Format("%-44s %12s %10s %12s %12s  %s", "case", "median ns", "MAD", "p99", "min", "calls x reps"));
+    Vector<BenchResult> result;
+    for(BenchCase& c : Cases()) {
+        if(filter.GetCount() && Key(c.group, c.name).Find(filter) < 0)
+            continue;
+        BenchResult r = Measure(c, warmup, reps, min_us);
+        RLOG(Format("%-44s %12.2f %10.2f %12.2f %12.2f  %d x %d",
+                    Key(r.group, r.name), r.median, r.mad, r.p99, r.min, r.calls, r.reps));
+        result.Add(r);
+    }
+
+    String json = Option(args, "--json");
+    if(json.GetCount()) {
+        ValueArray ra;
+        for(const BenchResult& r : result) {
+            ValueMap m;
+            m.Add("group", r.group);
+            m.Add("name", r.name);
+            m.Add("items", r.items);
+            m.Add("calls", r.calls);
+            m.Add("reps", r.reps);
+            m.Add("median_ns", r.median);
+            m.Add("mad_ns", r.mad);
+            m.Add("p99_ns", r.p99);
+            m.Add("min_ns", r.min);
+            ra.Add(m);
+        }
+        ValueArray na;
+        for(const String& s : note)
+            na.Add(s);
+        ValueMap out;
+        out.Add("time", AsString(GetSysTime()));
+        out.Add("environment", env);
+        out.Add("notes", na);
+        out.Add("results", ra);
+        if(SaveFile(json, AsJSON(out, true)))
+            RLOG("Results written to " << json);
+        else
+            RLOG("Cannot write " << json);
+    }
+
+    String compare = Option(args, "--compare");
+    int slower = compare.GetCount() ? Compare(result, compare) : 0;
+    BenchKeep(0);
+    return slower ? 1 : 0;
+}
@@ -0,0 +1,74 @@
+#include "ExampleBench.h"
+#include "../MappedFileIn.h"
+
+// FileIn against MappedFileIn (MyMappedFileExample.cpp). The file is written by the setup
+// and stays in the page cache, so this is the warm-cache throughput of the stream layer;
+// ns per item is ns per byte.
+
+enum { STREAM_BENCH_SIZE = 64 * 1024 * 1024 };
+
+struct StreamBenchFile {
+    String path = GetTempFileName();
+
+    StreamBenchFile() {
+        FileOut out(path);
+        for(int i = 0; out.GetSize() < STREAM_BENCH_SIZE; i++)
+            out << "line " << i << ";value=" << i * 3 << "\n";
+    }
+    ~StreamBenchFile() { DeleteFile(path); }
+};
+
+INITBLOCK {
+    RegisterBench("Streams", "FileIn Get 64 KB blocks", STREAM_BENCH_SIZE, [] {
+        auto file = std::make_shared<StreamBenchFile>();
+        return [=] {
+            FileIn in(file->path);
+            Buffer<byte> buf(65536);
+            int64 lines = 0;
+            for(;;) {
+                int n = in.Get(buf, 65536);
+                if(n <= 0)
+                    break;
+                for(const byte *s = buf, *e = buf + n; (s = (const byte *)memchr(s, '\n', e - s)); s++)
+                    lines++;
+            }
+            BenchKeep(lines);
+        };
+    });
+
+    RegisterBench("Streams", "MappedFileIn slices", STREAM_BENCH_SIZE, [] {
+        auto file = std::make_shared<StreamBenchFile>();
+        return [=] {
+            MappedFileIn in(file->path, MAPPED_SEQUENTIAL);
+            int64 lines = 0;
+            while(!in.IsEof()) {
+                MappedSlice s = in.GetSlice(65536);
+                for(const char *p = s.begin(); (p = (const char *)memchr(p, '\n', s.end() - p)); p++)
+                    lines++;
+            }
+            BenchKeep(lines);
+        };
+    });
+
+    RegisterBench("Streams", "FileIn GetLine", STREAM_BENCH_SIZE, [] {
+        auto file = std::make_shared<StreamBenchFile>();
+        return [=] {
+            FileIn in(file->path);
+            int64 chars = 0;
+            while(!in.IsEof())
+                chars += in.GetLine().GetCount();
+            BenchKeep(chars);
+        };
+    });
+
+    RegisterBench("Streams", "MappedFileIn GetLineSlice", STREAM_BENCH_SIZE, [] {
+        auto file = std::make_shared<StreamBenchFile>();
+        return [=] {
+            MappedFileIn in(file->path, MAPPED_SEQUENTIAL);
+            int64 chars = 0;
+            while(!in.IsEof())
+                chars += in.GetLineSlice().GetCount();
+            BenchKeep(chars);
+        };
+    });
+}
@@ -0,0 +1,18 @@
+#include "ExampleBench.h"
+
+#ifdef flagGUI
+#include <CtrlLib/CtrlLib.h>
+#endif
+
+// The GUI configuration only adds the CtrlLib cases, output goes to the console and log
+// like in the console build.
+
+#ifdef flagGUI
+GUI_APP_MAIN
+#else
+CONSOLE_APP_MAIN
+#endif
+{
+    StdLogSetup(LOG_COUT|LOG_FILE);
+    SetExitCode(RunBenchmarks(CommandLine()));
+}
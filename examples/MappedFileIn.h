@@ -0,0 +1,171 @@
+#ifndef _examples_MappedFileIn_h_
+#define _examples_MappedFileIn_h_
+
+#include <Core/Core.h>
+
+#ifdef PLATFORM_POSIX
+#include <sys/mman.h>
+#endif
+
+using namespace Upp;
+
+// Memory-mapped input stream (compare with FileIn in the guide's Streams section).
+//
+// FileIn reads the file through a buffer and every Get, GetLine or String load copies the
+// bytes once more. MappedFileIn maps the whole file with FileMapping and is a
+// MemReadStream over the mapping, so it works anywhere a Stream is expected (Serialize,
+// Load, GetLine...) without read calls, and GetSlice / Slice hand out MappedSlice views
+// that point straight into the mapping. Views stay valid while the stream is open.
+//
+// Open takes an access hint, passed to madvise on POSIX: MAPPED_SEQUENTIAL makes the
+// kernel read ahead aggressively and drop pages behind the reader, MAPPED_RANDOM turns
+// read-ahead off for lookups. huge_pages asks for transparent huge pages, which saves TLB
+// misses on multi-GB files; the kernel applies it to file mappings only when configured
+// for it, so it is a request, not a guarantee. On Windows the hints do nothing.
+//
+// MappedSlice can be serialized: storing writes it exactly like a String, loading from a
+// MappedFileIn reads the length and points into the mapping. A struct that serializes a
+// String can therefore be loaded into a "view" twin with MappedSlice members from the
+// same file, with no allocation per string (see MyMappedFileExample.cpp).
+
+enum { MAPPED_NORMAL, MAPPED_SEQUENTIAL, MAPPED_RANDOM };
+
+// Non-owning view of mapped bytes
+struct MappedSlice : Moveable<MappedSlice> {
+    const char *ptr = nullptr;
+    int         len = 0;
+
+    const char *begin() const         { return ptr; }
+    const char *end() const           { return ptr + len; }
+    int         GetCount() const      { return len; }
+    bool        IsEmpty() const       { return len == 0; }
+    char        operator[](int i) const { ASSERT(i >= 0 && i < len); return ptr[i]; }
+
+    String      ToString() const      { return String(ptr, len); }
+    bool        operator==(const char *s) const { return strlen(s) == (size_t)len && memcmp(ptr, s, len) == 0; }
+
+    MappedSlice() {}
+    MappedSlice(const char *ptr, int len) : ptr(ptr), len(len) {}
+};
+
+class MappedFileIn : public MemReadStream {
+    FileMapping map;
+
+public:
+    bool Open(const char *path, int hint = MAPPED_SEQUENTIAL, bool huge_pages = false) {
+        Close();
+        if(!map.Open(path))
+            return false;
+        int64 size = map.GetFileSize();
+        if(size == 0) {
+            Create("", 0);
+            return true;
+        }
+        if(!map.Map(0, (size_t)size)) {
+            map.Close();
+            return false;
+        }
+        Create(map.Begin(), size);
+        Advise(hint, huge_pages);
+        return true;
+    }
+
+    void Advise(int hint, bool huge_pages = false) {
+#ifdef PLATFORM_POSIX
+        if(!map.Begin())
+            return;
+        void *p = (void *)map.Begin();
+        size_t len = (size_t)map.GetFileSize();
+        if(hint == MAPPED_SEQUENTIAL)
+            madvise(p, len, MADV_SEQUENTIAL);
+        if(hint == MAPPED_RANDOM)
+            madvise(p, len, MADV_RANDOM);
+#ifdef MADV_HUGEPAGE
+        if(huge_pages)
+            madvise(p, len, MADV_HUGEPAGE);
+#endif
+#endif
+    }
+
+    // View of the next len bytes (fewer at the end of the file); advances the position
+    MappedSlice GetSlice(int len) {
+        int n = (int)min<int64>(max(len, 0), rdlim - ptr);
+        MappedSlice s((const char *)ptr, n);
+        ptr += n;
+        return s;
+    }
+
+    // View of the next line without the line terminator; advances past it
+    MappedSlice GetLineSlice() {
+        const byte *e = (const byte *)memchr(ptr, '\n', rdlim - ptr);
+        int n = int((e ? e : rdlim) - ptr);
+        MappedSlice s((const char *)ptr, n && ptr[n - 1] == '\r' ? n - 1 : n);
+        ptr += e ? n + 1 : n;
+        return s;
+    }
+
+    // View of any part of the file, independent of the position
+    MappedSlice Slice(int64 pos, int len) const {
+        ASSERT(pos >= 0 && pos + len <= map.GetFileSize());
+        return MappedSlice((const char *)map.Begin() + pos, len);
+    }
+
+    const byte *Begin() const { return map.Begin(); }
+    bool        IsMapped() const { return map.Begin(); }
+
+    void Close() {
+        Create("", 0);
+        map.Close();
+    }
+
+    MappedFileIn() : MemReadStream("", 0) {}
+    MappedFileIn(const char *path, int hint = MAPPED_SEQUENTIAL, bool huge_pages = false)
+        : MemReadStream("", 0) { Open(path, hint, huge_pages); }
+    ~MappedFileIn() { Close(); }
+};
+
+// Same format as Stream::operator%(String&): lengths below 127 in one byte, others as
+// 0xff and 32 bits little endian; a first byte with bit 7 set is a 7 bit length followed
+// by a reserved byte
+inline Stream& operator%(Stream& s, MappedSlice& x)
+{
+    if(s.IsStoring()) {
+        if(x.len < 127)
+            s.Put(x.len);
+        else {
+            s.Put(0xff);
+            s.Put32le(x.len);
+        }
+        s.Put(x.ptr, x.len);
+        return s;
+    }
+    int c = s.Get();
+    if(c < 0) {
+        s.LoadError();
+        return s;
+    }
+    dword len = c;
+    if(len == 0xff)
+        len = s.Get32le();
+    else
+    if(len & 0x80) {
+        len &= 0x7f;
+        s.Get();
+    }
+    MappedFileIn *in = dynamic_cast<MappedFileIn *>(&s);
+    if(s.IsError() || !in || len > (dword)in->GetLeft()) {
+        s.LoadError(); // views need the mapping to point into
+        return s;
+    }
+    x = in->GetSlice(len);
+    return s;
+}
+
+// LoadFromFile through the mapping
+template <class T>
+bool LoadFromMappedFile(T& x, MappedFileIn& in, const char *path, int hint = MAPPED_SEQUENTIAL)
+{
+    return in.Open(path, hint) && Load(x, in);
+}
+
+#endif
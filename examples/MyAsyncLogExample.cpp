@@ -0,0 +1,309 @@
+#include <Core/Core.h>
+
+using namespace Upp;
+
+// Asynchronous log sink for hot paths (compare with LOG / RLOG after StdLogSetup in the
+// other examples).
+//
+// RLOG formats the message on the calling thread and writes it to the log under a mutex,
+// so logging from a CoPartition lambda serializes the workers on that mutex and on the
+// write. AsyncLog moves all of that off the hot path:
+//
+//  - each thread gets its own single-producer ring of fixed-size records, so logging
+//    takes no lock (a mutex is used once per thread, to register the ring). When the
+//    thread exits its ring is retired, and the writer frees it once it is drained
+//  - a record stores the time, the format string pointer and up to 6 typed arguments
+//    (integers, doubles, and text copied into the record); nothing is formatted yet
+//  - a writer thread drains all rings, orders the batch by time, formats it with Format
+//    and appends it to the file with a single FileAppend write
+//  - when a ring is full the record is either dropped and counted (ALOG_DROP) or the
+//    thread waits for the writer (ALOG_BLOCK). Without a running writer (before Start,
+//    after Stop) nobody would empty the ring, so full rings always drop
+//
+// The LOG(a << b) stream syntax formats immediately, so the deferred API uses a format
+// string instead: ALOG("item %d took %.2f ms", i, t). The format string must be a literal
+// (or otherwise outlive the logger), text arguments are truncated to fit the record.
+
+enum { ALOG_DROP, ALOG_BLOCK };
+
+enum { ALOG_INT, ALOG_DOUBLE, ALOG_TEXT };
+
+struct AsyncLogRecord : Moveable<AsyncLogRecord> {
+    enum { MAXARGS = 6, TEXT = 64 };
+
+    int64       time;
+    const char *fmt;
+    int         thread;
+    byte        count;
+    byte        textlen;
+    byte        type[MAXARGS];
+    int64       arg[MAXARGS];   // value, double bits, or text offset << 8 | length
+    char        text[TEXT];
+};
+
+inline void AsyncLogArg(AsyncLogRecord& r, int64 x)  { r.type[r.count] = ALOG_INT; r.arg[r.count++] = x; }
+inline void AsyncLogArg(AsyncLogRecord& r, int x)    { AsyncLogArg(r, (int64)x); }
+inline void AsyncLogArg(AsyncLogRecord& r, dword x)  { AsyncLogArg(r, (int64)x); }
+inline void AsyncLogArg(AsyncLogRecord& r, long x)   { AsyncLogArg(r, (int64)x); }
+inline void AsyncLogArg(AsyncLogRecord& r, unsigned long x) { AsyncLogArg(r, (int64)x); }
+inline void AsyncLogArg(AsyncLogRecord& r, uint64 x) { AsyncLogArg(r, (int64)x); }
+inline void AsyncLogArg(AsyncLogRecord& r, bool x)   { AsyncLogArg(r, (int64)x); }
+
+inline void AsyncLogArg(AsyncLogRecord& r, double x)
+{
+    r.type[r.count] = ALOG_DOUBLE;
+    memcpy(&r.arg[r.count++], &x, sizeof(x));
+}
+
+inline void AsyncLogArg(AsyncLogRecord& r, const char *s, int len)
+{
+    len = min(len, AsyncLogRecord::TEXT - r.textlen);
+    memcpy(r.text + r.textlen, s, len);
+    r.type[r.count] = ALOG_TEXT;
+    r.arg[r.count++] = ((int64)r.textlen << 8) | len;
+    r.textlen += len;
+}
+
+inline void AsyncLogArg(AsyncLogRecord& r, const char *s)   { AsyncLogArg(r, s, (int)strlen(s)); }
+inline void AsyncLogArg(AsyncLogRecord& r, const String& s) { AsyncLogArg(r, ~s, s.GetCount()); }
+
+// Single producer / single consumer ring of records
+class AsyncLogRing : NoCopy {
+    Buffer<AsyncLogRecord> slot;
+    int                    mask;
+    int                    thread;
+    byte                   pad0[64];
+    std::atomic<int64>     head;      // written by the producer
+    byte                   pad1[64];
+    std::atomic<int64>     tail;      // written by the writer thread
+    std::atomic<bool>      retired;   // the producer thread has exited
+
+public:
+    // Producer: free slot or nullptr when full; Commit publishes it
+    AsyncLogRecord *Begin() {
+        int64 h = head.load(std::memory_order_relaxed);
+        if(h - tail.load(std::memory_order_acquire) > mask)
+            return nullptr;
+        AsyncLogRecord *r = &slot[h & mask];
+        r->thread = thread;
+        return r;
+    }
+    void Commit()                 { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Consumer
+    const AsyncLogRecord *Front() {
+        int64 t = tail.load(std::memory_order_relaxed);
+        return t < head.load(std::memory_order_acquire) ? &slot[t & mask] : nullptr;
+    }
+    void Pop()                    { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+    // Producer's last call; after it the writer may free the ring
+    void Retire()                 { retired.store(true, std::memory_order_release); }
+    bool IsRetired() const        { return retired.load(std::memory_order_acquire); }
+
+    AsyncLogRing(int capacity, int thread) : slot(capacity), mask(capacity - 1), thread(thread) {
+        ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0);
+        head = tail = 0;
+        retired = false;
+    }
+};
+
+class AsyncLogger : NoCopy {
+    Mutex               lock;
+    Array<AsyncLogRing> ring;                // under lock; removed only by the writer thread
+    int                 threads = 0;         // under lock, number for the next ring
+    Thread              writer;
+    std::atomic<bool>   stop;
+    std::atomic<bool>   running;             // a writer is draining the rings
+    std::atomic<int64>  dropped;
+    std::atomic<int64>  written;
+    int                 policy = ALOG_DROP;
+    int                 capacity = 4096;
+    int64               start = 0;
+
+    // Retires the thread's ring when the thread exits
+    struct ThreadRingOwner {
+        AsyncLogRing *r = nullptr;
+        ~ThreadRingOwner() { if(r) r->Retire(); }
+    };
+
+    AsyncLogRing& ThreadRing() {
+        thread_local ThreadRingOwner owner;
+        if(!owner.r) {
+            Mutex::Lock __(lock);
+            owner.r = &ring.Add(new AsyncLogRing(capacity, threads++));
+        }
+        return *owner.r;
+    }
+
+    // Writer thread: frees retired rings that have been drained
+    void Sweep() {
+        Mutex::Lock __(lock);
+        for(int i = ring.GetCount() - 1; i >= 0; i--)
+            if(ring[i].IsRetired() && !ring[i].Front()) // retired first: its last records are visible
+                ring.Remove(i);
+    }
+
+    // Writer thread: drains every ring, returns number of records written
+    int Drain(FileAppend& out) {
+        Sweep();
+        Vector<AsyncLogRing *> rs;
+        {
+            Mutex::Lock __(lock);
+            for(AsyncLogRing& r : ring)
+                rs.Add(&r);
+        }
+        Vector<AsyncLogRecord> batch;
+        for(AsyncLogRing *r : rs)
+            while(const AsyncLogRecord *rec = r->Front()) {
+                batch.Add(*rec);
+                r->Pop();
+            }
+        if(batch.IsEmpty())
+            return 0;
+        StableSort(batch, [](const AsyncLogRecord& a, const AsyncLogRecord& b) { return a.time < b.time; });
+        StringBuffer sb;
+        Vector<Value> v;
+        for(const AsyncLogRecord& r : batch) {
+            v.Clear();
+            for(int i = 0; i < r.count; i++)
+                if(r.type[i] == ALOG_INT)
+                    v.Add(r.arg[i]);
+                else
+                if(r.type[i] == ALOG_DOUBLE) {
+                    double d;
+                    memcpy(&d, &r.arg[i], sizeof(d));
+                    v.Add(d);
+                }
+                else
+                    v.Add(String(r.text + (r.arg[i] >> 8), int(r.arg[i] & 255)));
+            sb << Format("%12.6f [%d] ", (r.time - start) / 1e6, r.thread) << Format(r.fmt, v) << '\n';
+        }
+        out.Put(String(sb));
+        written += batch.GetCount();
+        return batch.GetCount();
+    }
+
+    void WriterLoop(String path) {
+        FileAppend out(path);
+        for(;;) {
+            bool s = stop;
+            if(!Drain(out)) {
+                if(s)
+                    break;
+                Sleep(1);
+            }
+        }
+        out.Close();
+        running = false;
+    }
+
+public:
+    static AsyncLogger& Get() { return Single<AsyncLogger>(); }
+
+    // capacity is the number of records per thread, a power of two
+    void Start(const String& path, int policy_ = ALOG_DROP, int capacity_ = 4096) {
+        policy = policy_;
+        capacity = capacity_;
+        start = usecs();
+        stop = false;
+        running = true;
+        writer.Run([=] { WriterLoop(path); });
+    }
+
+    // Writes everything that was logged so far and stops the writer
+    void Stop() {
+        stop = true;
+        writer.Wait();
+    }
+
+    template <class... Args>
+    void Log(const char *fmt, const Args&... args) {
+        static_assert(sizeof...(Args) <= AsyncLogRecord::MAXARGS, "too many AsyncLog arguments");
+        AsyncLogRing& r = ThreadRing();
+        AsyncLogRecord *p = r.Begin();
+        if(!p) {
+            for(;;) {
+                if(policy == ALOG_DROP || !running) { // without a writer the ring never empties
+                    dropped++;
+                    return;
+                }
+                if((p = r.Begin()))
+                    break;
+                Sleep(0);
+            }
+        }
+        p->time = usecs();
+        p->fmt = fmt;
+        p->count = 0;
+        p->textlen = 0;
+        (AsyncLogArg(*p, args), ...);
+        r.Commit();
+    }
+
+    int64 GetDropped() const { return dropped; }
+    int64 GetWritten() const { return written; }
+
+    AsyncLogger() { stop = false; running = false; dropped = written = 0; }
+};
+
+#define ALOG(...) AsyncLogger::Get().Log(__VA_ARGS__)
+
+// Runs 'threads' threads logging 'count' messages each; returns ns per message
+template <class Fn>
+static double LogBench(int threads, int count, const Fn& log)
+{
+    Array<Thread> t;
+    int64 t0 = usecs();
+    for(int i = 0; i < threads; i++)
+        t.Add().Run([=] {
+            for(int j = 0; j < count; j++)
+                log(i, j);
+        });
+    for(Thread& x : t)
+        x.Wait();
+    return usecs(t0) * 1000.0 / count; // wall time per message of one thread
+}
+
+CONSOLE_APP_MAIN {
+    StdLogSetup(LOG_FILE); // the benchmark logs millions of lines, keep them off the console
+
+    String path = GetTempFileName();
+    int count = 200000;
+    Vector<String> report;
+
+    AsyncLogger& log = AsyncLogger::Get();
+    log.Start(path, ALOG_BLOCK, 8192);
+    for(int threads : { 1, 2, 4, 8 }) {
+        double ns_sync = LogBench(threads, count, [](int t, int j) {
+            RLOG("worker " << t << " item " << j << " value " << j * 0.5);
+        });
+        double ns_async = LogBench(threads, count, [](int t, int j) {
+            ALOG("worker %d item %d value %.1f", t, j, j * 0.5);
+        });
+        report.Add(Format("%d threads: RLOG %7.0f ns/message, ALOG %5.0f ns/message, %.1fx",
+                          threads, ns_sync, ns_async, ns_sync / ns_async));
+    }
+    log.Stop();
+    int64 expected = (int64)count * (1 + 2 + 4 + 8);
+    report.Add(Format("ALOG_BLOCK: %d of %d records written, %d KB", log.GetWritten(), expected,
+                      (int)(GetFileLength(path) / 1024)));
+    DeleteFile(path);
+
+    // Small rings with the drop policy: producers never wait, overflow is counted
+    int64 written0 = log.GetWritten();
+    log.Start(path, ALOG_DROP, 256);
+    double ns_drop = LogBench(4, count, [](int t, int j) {
+        ALOG("worker %d item %d value %.1f", t, j, j * 0.5);
+    });
+    log.Stop();
+    report.Add(Format("ALOG_DROP, 256 records per thread: %.0f ns/message, %d written, %d dropped",
+                      ns_drop, log.GetWritten() - written0, log.GetDropped()));
+    DeleteFile(path);
+
+    StdLogSetup(LOG_COUT|LOG_FILE);
+    for(const String& s : report)
+        RLOG(s);
+    RLOG("Log lines look like this:");
+    RLOG(Format("%12.6f [%d] ", 0.000123, 0) + Format("worker %d item %d value %.1f", 0, 1, 0.5));
+}
@@ -0,0 +1,238 @@
+#include <Core/Core.h>
+
+using namespace Upp;
+
+// Fixed-layout, versioned binary snapshots with zero-copy loading
+// (compare with MySerializationExample.cpp).
+//
+// StoreToFile / LoadFromFile go through Serialize: loading parses the whole stream and
+// allocates a String per object. For large snapshots that means the load time and memory
+// are proportional to the whole file even if only a few records are looked at.
+//
+// The snapshot format below has a fixed layout instead:
+//
+//   SnapshotHeader    magic, version, record size, record count, string area position
+//   SnapshotRecord[]  one fixed 16 byte record per object
+//   string area       all names back to back, records refer to them by offset and length
+//
+// SnapshotView maps the file with FileMapping and hands out read-only views pointing into
+// the mapping. Opening is O(1); pages are only read when a record is actually accessed.
+// Integers are stored little endian, which is what every platform U++ targets uses.
+//
+// Peak RSS is per process, so for clean numbers run "--mode=create" once and then
+// "--mode=serialize" and "--mode=mapped" as separate processes. Without --mode the example
+// creates the files and runs both loaders one after the other.
+
+// Define a simple struct for serialization (same as MySerializationExample.cpp)
+struct MySerializableObject : Moveable<MySerializableObject> {
+    String name;
+    int    value;
+
+    MySerializableObject() : value(0) {}
+    MySerializableObject(String n, int v) : name(n), value(v) {}
+
+    void Serialize(Stream& s) {
+        s % name % value;
+    }
+
+    String ToString() const {
+        return Sprintf("Name: %s, Value: %d", name, value);
+    }
+};
+
+enum { SNAPSHOT_VERSION = 1 };
+
+static const char snapshot_magic[8] = { 'U', 'P', 'P', 'S', 'N', 'A', 'P', 0 };
+
+struct SnapshotHeader {
+    char   magic[8];
+    dword  version;
+    dword  record_size;
+    int64  count;
+    int64  strings_offset; // from the start of file
+    int64  strings_size;
+};
+
+struct SnapshotRecord {
+    int64  name_offset;    // from the start of the string area
+    int    name_len;
+    int    value;
+};
+
+static_assert(sizeof(SnapshotHeader) == 40, "unexpected padding in SnapshotHeader");
+static_assert(sizeof(SnapshotRecord) == 16, "unexpected padding in SnapshotRecord");
+
+// Non-owning view of characters inside the mapping
+struct SnapshotString {
+    const char *ptr = nullptr;
+    int         len = 0;
+
+    String ToString() const                 { return String(ptr, len); }
+    bool   operator==(const char *s) const  { return (int)strlen(s) == len && memcmp(ptr, s, len) == 0; }
+};
+
+// Read-only view of one MySerializableObject in a snapshot
+struct MySerializableObjectView {
+    SnapshotString name;
+    int            value;
+
+    MySerializableObject Get() const { return MySerializableObject(name.ToString(), value); }
+};
+
+bool StoreSnapshot(const Vector<MySerializableObject>& data, const char *path)
+{
+    SnapshotHeader h;
+    memcpy(h.magic, snapshot_magic, sizeof(h.magic));
+    h.version = SNAPSHOT_VERSION;
+    h.record_size = sizeof(SnapshotRecord);
+    h.count = data.GetCount();
+    h.strings_offset = sizeof(SnapshotHeader) + h.count * sizeof(SnapshotRecord);
+    h.strings_size = 0;
+    for(const MySerializableObject& o : data)
+        h.strings_size += o.name.GetCount();
+
+    FileOut out(path);
+    if(!out)
+        return false;
+    out.Put(&h, sizeof(h));
+    int64 offset = 0;
+    for(const MySerializableObject& o : data) {
+        SnapshotRecord r;
+        r.name_offset = offset;
+        r.name_len = o.name.GetCount();
+        r.value = o.value;
+        out.Put(&r, sizeof(r));
+        offset += r.name_len;
+    }
+    for(const MySerializableObject& o : data)
+        out.Put(o.name);
+    out.Close();
+    return !out.IsError();
+}
+
+class SnapshotView : NoCopy {
+    FileMapping           map;
+    const SnapshotRecord *record = nullptr;
+    const char           *strings = nullptr;
+    int64                 strings_size = 0;
+    int                   count = 0;
+
+public:
+    // Checks the header and maps the file; does not touch the records
+    bool Open(const char *path) {
+        Close();
+        if(!map.Open(path) || map.GetFileSize() < (int64)sizeof(SnapshotHeader) ||
+           !map.Map(0, (size_t)map.GetFileSize()))
+            return false;
+        const SnapshotHeader& h = *(const SnapshotHeader *)map.Begin();
+        if(memcmp(h.magic, snapshot_magic, sizeof(h.magic)) || h.version > SNAPSHOT_VERSION ||
+           h.record_size != sizeof(SnapshotRecord) || h.count < 0 || h.count > INT_MAX ||
+           h.strings_offset != (int64)sizeof(SnapshotHeader) + h.count * (int64)sizeof(SnapshotRecord) ||
+           h.strings_offset + h.strings_size > map.GetFileSize()) {
+            Close();
+            return false;
+        }
+        record = (const SnapshotRecord *)(map.Begin() + sizeof(SnapshotHeader));
+        strings = (const char *)map.Begin() + h.strings_offset;
+        strings_size = h.strings_size;
+        count = (int)h.count;
+        return true;
+    }
+
+    void Close() {
+        map.Close();
+        record = nullptr;
+        strings = nullptr;
+        count = 0;
+    }
+
+    int GetCount() const { return count; }
+
+    MySerializableObjectView operator[](int i) const {
+        ASSERT(i >= 0 && i < count);
+        const SnapshotRecord& r = record[i];
+        MySerializableObjectView v;
+        v.value = r.value;
+        if(r.name_offset >= 0 && r.name_len >= 0 && r.name_offset + r.name_len <= strings_size) {
+            v.name.ptr = strings + r.name_offset;
+            v.name.len = r.name_len;
+        }
+        return v;
+    }
+
+    ~SnapshotView() { Close(); }
+};
+
+static int PeakRssKb()
+{
+#ifdef PLATFORM_LINUX
+    String s = LoadFile("/proc/self/status");
+    int q = s.Find("VmHWM:");
+    if(q >= 0)
+        return atoi(~s + q + 6);
+#endif
+    return 0;
+}
+
+CONSOLE_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    String mode;
+    for(const String& a : CommandLine())
+        if(a.StartsWith("--mode="))
+            mode = a.Mid(7);
+
+    int count = 2000000;
+    String serialized = AppendFileName(GetTempDirectory(), "snapshot_bench.serialized");
+    String snapshot = AppendFileName(GetTempDirectory(), "snapshot_bench.snapshot");
+    if(mode.IsEmpty() || mode == "create") {
+        Vector<MySerializableObject> data;
+        for(int i = 0; i < count; i++)
+            data.Add(MySerializableObject(Format("Object number %d", i), i));
+        StoreToFile(data, serialized);
+        StoreSnapshot(data, snapshot);
+        RLOG(count << " objects, Serialize file " << GetFileLength(serialized) / 1024 << " KB, snapshot "
+             << GetFileLength(snapshot) / 1024 << " KB");
+        if(mode == "create")
+            return;
+    }
+    int rss0 = PeakRssKb();
+
+    if(mode.IsEmpty() || mode == "serialize") {
+        int mem0 = MemoryUsedKb();
+        int64 t0 = usecs();
+        Vector<MySerializableObject> loaded;
+        if(!LoadFromFile(loaded, serialized))
+            RLOG("LoadFromFile failed");
+        int64 t_load = usecs(t0);
+        int64 check = 0;
+        for(const MySerializableObject& o : loaded)
+            check += o.value + o.name.GetCount();
+        RLOG(Format("LoadFromFile: %8.1f ms load, %.1f ms total, heap +%d KB, peak RSS %d KB (check %d)",
+                    t_load / 1000.0, usecs(t0) / 1000.0, MemoryUsedKb() - mem0, PeakRssKb(), check));
+    }
+
+    if(mode.IsEmpty() || mode == "mapped") {
+        int mem0 = MemoryUsedKb();
+        int64 t0 = usecs();
+        SnapshotView view;
+        if(!view.Open(snapshot))
+            RLOG("SnapshotView::Open failed");
+        int64 t_open = usecs(t0);
+        int64 check = 0;
+        for(int i = 0; i < view.GetCount(); i++) {
+            MySerializableObjectView v = view[i];
+            check += v.value + v.name.len;
+        }
+        RLOG(Format("SnapshotView: %8.3f ms open, %.1f ms total, heap +%d KB, peak RSS %d KB (check %d)",
+                    t_open / 1000.0, usecs(t0) / 1000.0, MemoryUsedKb() - mem0, PeakRssKb(), check));
+        if(view.GetCount())
+            DUMP(view[view.GetCount() / 2].Get());
+    }
+    RLOG("Peak RSS before loading: " << rss0 << " KB");
+
+    if(mode.IsEmpty()) {
+        DeleteFile(serialized);
+        DeleteFile(snapshot);
+    }
+}
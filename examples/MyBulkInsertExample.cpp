@@ -0,0 +1,245 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Batched, repaint-suppressed inserts into ArrayCtrl and TreeCtrl.
+//
+// MyArrayCtrlExample.cpp and MyTreeCtrlExample.cpp insert one item at a time. That is fine
+// for a handful of rows, but a background feed that posts every row to the GUI thread
+// makes the event loop run one Add (with its scrollbar and layout update) per row and
+// starves painting. This example streams 200k rows from a worker thread in two modes:
+//
+//  - Per row:  every row is a separate PostCallback doing ArrayCtrl::Add / TreeCtrl::Add.
+//  - Batched:  the worker fills chunks into a shared queue and posts a single commit
+//              callback; the GUI thread inserts the whole chunk with AddRows / AddNodes.
+//
+// A 16 ms periodic timer measures how often the event loop gets around to it, which is
+// the frame time the user sees. The status line reports p50 / p99 / max for each run.
+
+// Appends rows in one step: the row count (and so the scrollbar) is updated once,
+// then the rows are moved into place.
+void AddRows(ArrayCtrl& list, Vector<Vector<Value>>&& rows)
+{
+    int base = list.GetCount();
+    list.SetCount(base + rows.GetCount());
+    for(int i = 0; i < rows.GetCount(); i++)
+        list.Set(base + i, pick(rows[i]));
+}
+
+// Adds children of one parent. The parent is closed while inserting so the visible line
+// layout is rebuilt once, when it is opened again.
+void AddNodes(TreeCtrl& tree, int parent, const Array<TreeCtrl::Node>& nodes)
+{
+    bool open = parent && tree.IsOpen(parent);
+    if(open)
+        tree.Close(parent);
+    for(const TreeCtrl::Node& n : nodes)
+        tree.Add(parent, n);
+    if(open)
+        tree.Open(parent);
+}
+
+// Begin/commit front end for AddRows
+class ArrayCtrlBatch {
+    ArrayCtrl&            list;
+    Vector<Vector<Value>> rows;
+
+public:
+    Vector<Value>& Add()                      { return rows.Add(); }
+    void           Add(Vector<Value>&& row)   { rows.Add(pick(row)); }
+    int            GetCount() const           { return rows.GetCount(); }
+    void           Commit()                   { AddRows(list, pick(rows)); rows.Clear(); }
+
+    ArrayCtrlBatch(ArrayCtrl& list) : list(list) {}
+    ~ArrayCtrlBatch()                         { Commit(); }
+};
+
+// Measures intervals between ticks of a periodic timer
+class FrameMeter {
+    Vector<int> frames; // microseconds
+    int64       last = 0;
+
+public:
+    void Tick() {
+        int64 now = usecs();
+        if(last)
+            frames.Add(int(now - last));
+        last = now;
+    }
+
+    void Reset() { frames.Clear(); last = 0; }
+
+    String Report() const {
+        if(frames.IsEmpty())
+            return "no frames";
+        Vector<int> f = clone(frames);
+        Sort(f);
+        return Format("frame p50 %.1f ms, p99 %.1f ms, max %.1f ms (%d frames)",
+                      f[f.GetCount() / 2] / 1000.0, f[f.GetCount() * 99 / 100] / 1000.0,
+                      f.Top() / 1000.0, f.GetCount());
+    }
+};
+
+struct FeedRow : Moveable<FeedRow> {
+    int    id;
+    String name;
+};
+
+class MyBulkInsertWindow : public TopWindow {
+public:
+    typedef MyBulkInsertWindow CLASSNAME;
+
+    enum { ROWS = 200000, CHUNK = 4096, GROUP = 1000 };
+
+    ArrayCtrl   list;
+    TreeCtrl    tree;
+    Splitter    splitter;
+    Button      perRow, batched;
+    Label       status;
+    FrameMeter  meter;
+
+    Thread      feed;
+    Atomic      stop;
+    Mutex       lock;
+    Vector<FeedRow> pending;        // produced by the worker, waiting for Commit
+    bool        commitPosted = false;
+
+    Vector<int> groups;             // tree node id per GROUP rows
+    int         run = 0;            // callbacks of an earlier run are ignored
+    int64       started = 0;
+
+    int GroupNode(int id) {
+        int g = id / GROUP;
+        while(groups.GetCount() <= g)
+            groups.Add(tree.Add(0, Null, Format("Rows %d..%d", groups.GetCount() * GROUP,
+                                                (groups.GetCount() + 1) * GROUP - 1)));
+        return groups[g];
+    }
+
+    void StopFeed() {
+        stop = 1;
+        feed.Wait();
+        stop = 0;
+        pending.Clear();
+        commitPosted = false;
+    }
+
+    void Start(bool batch) {
+        StopFeed();
+        list.Clear();
+        tree.Clear();
+        groups.Clear();
+        meter.Reset();
+        started = usecs();
+        status.SetLabel(batch ? "Batched feed running..." : "Per-row feed running...");
+        int gen = ++run;
+        feed.Run([=] { batch ? FeedBatched(gen) : FeedPerRow(gen); });
+    }
+
+    // Worker thread: one PostCallback per row (the "before" case)
+    void FeedPerRow(int gen) {
+        for(int i = 0; i < ROWS && !stop; i++) {
+            String name = Format("Trade %d", i);
+            PostCallback([=] {
+                if(gen != run)
+                    return;
+                list.Add(i, name);
+                tree.Add(GroupNode(i), Null, name);
+            });
+        }
+        PostCallback([=] { if(gen == run) Finished("Per row"); });
+    }
+
+    // Worker thread: chunks into 'pending', at most one commit callback in flight
+    void FeedBatched(int gen) {
+        Vector<FeedRow> chunk;
+        for(int i = 0; i < ROWS && !stop; i++) {
+            FeedRow& r = chunk.Add();
+            r.id = i;
+            r.name = Format("Trade %d", i);
+            if(chunk.GetCount() >= CHUNK || i == ROWS - 1) {
+                Mutex::Lock __(lock);
+                pending.AppendPick(pick(chunk));
+                chunk.Clear();
+                if(!commitPosted) {
+                    commitPosted = true;
+                    PostCallback([=] { Commit(); });
+                }
+            }
+        }
+        PostCallback([=] {
+            if(gen == run) {
+                Commit();
+                Finished("Batched");
+            }
+        });
+    }
+
+    // GUI thread: inserts everything the worker has produced since the last commit
+    void Commit() {
+        Vector<FeedRow> rows;
+        {
+            Mutex::Lock __(lock);
+            rows = pick(pending);
+            pending.Clear();
+            commitPosted = false;
+        }
+        if(rows.IsEmpty())
+            return;
+
+        Vector<Vector<Value>> cells;
+        cells.Reserve(rows.GetCount());
+        for(const FeedRow& r : rows)
+            cells.Add() << r.id << r.name;
+        AddRows(list, pick(cells));
+
+        // Rows arrive in id order, so each group is a contiguous run
+        for(int i = 0; i < rows.GetCount();) {
+            int parent = GroupNode(rows[i].id);
+            Array<TreeCtrl::Node> nodes;
+            int g = rows[i].id / GROUP;
+            for(; i < rows.GetCount() && rows[i].id / GROUP == g; i++)
+                nodes.Add(TreeCtrl::Node(Null, rows[i].name));
+            AddNodes(tree, parent, nodes);
+        }
+    }
+
+    void Finished(const char *mode) {
+        status.SetLabel(Format("%s: %d rows in %.0f ms, %s", mode, list.GetCount(),
+                               usecs(started) / 1000.0, meter.Report()));
+        RLOG(status.GetText());
+    }
+
+    MyBulkInsertWindow() {
+        Title("Bulk insert: ArrayCtrl + TreeCtrl");
+        SetRect(0, 0, 700, 500);
+        Sizeable().Zoomable();
+
+        list.AddColumn("ID", 60);
+        list.AddColumn("Name", 150);
+        splitter.Horz(list, tree);
+
+        perRow.SetLabel("Per-row feed");
+        perRow << [=] { Start(false); };
+        batched.SetLabel("Batched feed");
+        batched << [=] { Start(true); };
+
+        Add(perRow.TopPos(4, 24).LeftPos(4, 120));
+        Add(batched.TopPos(4, 24).LeftPos(130, 120));
+        Add(status.TopPos(4, 24).HSizePos(260, 4));
+        Add(splitter.VSizePos(32, 0).HSizePos());
+
+        stop = 0;
+        SetTimeCallback(-16, [=] { meter.Tick(); });
+    }
+
+    ~MyBulkInsertWindow() {
+        StopFeed(); // pending PostCallbacks are killed with the Ctrl
+    }
+};
+
+// Main function for the GUI application
+GUI_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+    MyBulkInsertWindow().Run();
+}
@@ -0,0 +1,210 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Display with cached text rendering (compare with MyColorValueDisplay in
+// MyColorValueExample.cpp).
+//
+// MyColorValueDisplay draws the name with a text call for every cell on every repaint,
+// and MyColorValueCtrl creates a new display object in each Paint. CachedTextDisplay
+// renders each (font, ink, text) combination once into an Image with an alpha channel,
+// keeps the images in a byte-bounded LRUCache and paints cells by drawing the image, so
+// repainting an unchanged cell is a blit. The text is rendered on a transparent
+// background, so the same image works on any paper (selected rows change the ink and
+// get their own entry).
+//
+// Displays are stateless apart from the cache, so one shared instance (Single<>) serves
+// every column and control. The cache is only used from the GUI thread, which is where
+// Display::Paint runs.
+//
+// Run with "--bench" to paint 60-row scroll frames with the plain and the cached display.
+
+struct MyColorValue {
+    Color  colorVal;
+    String name;
+
+    MyColorValue() : colorVal(Black()) {}
+    MyColorValue(Color c, String n) : colorVal(c), name(n) {}
+
+    String ToString() const { return Sprintf("%s (%s)", name, colorVal.ToString()); }
+};
+
+// Base for Displays that draw text; PaintText replaces Draw::DrawText
+class CachedTextDisplay : public Display {
+    struct TextMaker : LRUCache<Image>::Maker {
+        Font   font;
+        Color  ink;
+        String text;
+
+        virtual String Key() const {
+            StringBuffer k;
+            int64 f = font.AsInt64();
+            dword c = ink.GetRaw();
+            k.Cat((const char *)&f, sizeof(f));
+            k.Cat((const char *)&c, sizeof(c));
+            k.Cat(text);
+            return String(k);
+        }
+
+        virtual int Make(Image& img) const {
+            Size sz = GetTextSize(text, font);
+            if(sz.cx <= 0 || sz.cy <= 0) {
+                img = Image();
+                return 0;
+            }
+            ImageDraw iw(sz);
+            iw.DrawRect(sz, ink);
+            iw.Alpha().DrawRect(sz, GrayColor(0));
+            iw.Alpha().DrawText(0, 0, text, font, GrayColor(255));
+            img = iw;
+            return sz.cx * sz.cy * sizeof(RGBA);
+        }
+    };
+
+    mutable LRUCache<Image> cache;
+    int                     max_bytes = 4 * 1024 * 1024;
+
+public:
+    void PaintText(Draw& w, int x, int y, const String& text, Font font, Color ink) const {
+        TextMaker m;
+        m.font = font;
+        m.ink = ink;
+        m.text = text;
+        w.DrawImage(x, y, cache.Get(m));
+        cache.Shrink(max_bytes);
+    }
+
+    void SetCacheSize(int bytes)     { max_bytes = bytes; cache.Shrink(max_bytes); }
+    int  GetCacheBytes() const       { return cache.GetSize(); }
+    int  GetHits() const             { return cache.GetFoundCount(); }
+    int  GetMisses() const           { return cache.GetNewCount(); }
+    void ClearCounters()             { cache.ClearCounters(); }
+};
+
+// MyColorValueDisplay with the name drawn through the cache
+class MyColorValueDisplay : public CachedTextDisplay {
+public:
+    virtual void Paint(Draw& w, const Rect& r, const Value& q,
+                       Color ink, Color paper, dword style) const {
+        w.DrawRect(r, paper);
+        if(!q.Is<MyColorValue>()) {
+            StdDisplay().Paint(w, r, q, ink, paper, style);
+            return;
+        }
+        const MyColorValue& mcv = q.Get<MyColorValue>();
+        Rect colorBox = r;
+        colorBox.right = r.left + r.GetHeight();
+        w.DrawRect(colorBox, mcv.colorVal);
+        Font font = StdFont();
+        PaintText(w, colorBox.right + 4, r.top + (r.GetHeight() - font.GetCy()) / 2, mcv.name, font, ink);
+    }
+};
+
+// The same display without the cache, for the benchmark
+class MyColorValuePlainDisplay : public Display {
+public:
+    virtual void Paint(Draw& w, const Rect& r, const Value& q,
+                       Color ink, Color paper, dword style) const {
+        w.DrawRect(r, paper);
+        const MyColorValue& mcv = q.Get<MyColorValue>();
+        Rect colorBox = r;
+        colorBox.right = r.left + r.GetHeight();
+        w.DrawRect(colorBox, mcv.colorVal);
+        Font font = StdFont();
+        w.DrawText(colorBox.right + 4, r.top + (r.GetHeight() - font.GetCy()) / 2, mcv.name, font, ink);
+    }
+};
+
+class MyColorValueCtrl : public Ctrl {
+public:
+    MyColorValue data;
+
+    virtual void Paint(Draw& w) {
+        Single<MyColorValueDisplay>().Paint(w, GetSize(), RawToValue(data), SColorText, SColorPaper, 0);
+    }
+
+    void SetData(const MyColorValue& mcv) {
+        data = mcv;
+        Refresh();
+    }
+
+    MyColorValueCtrl() { data = MyColorValue(Cyan(), "Default"); }
+};
+
+static MyColorValue MakeSwatch(int i)
+{
+    static const char *names[] = { "Primary", "Secondary", "Accent", "Warning", "Error", "Info", "Muted" };
+    return MyColorValue(Color(37 * i & 255, 91 * i & 255, 53 * i & 255),
+                        Format("%s %d", names[i % 7], i % 50));
+}
+
+struct MyCachedDisplayWindow : TopWindow {
+    typedef MyCachedDisplayWindow CLASSNAME;
+
+    MyColorValueCtrl header;
+    ArrayCtrl        list;
+    Label            status;
+
+    void SyncStatus() {
+        const MyColorValueDisplay& d = Single<MyColorValueDisplay>();
+        status.SetLabel(Format("Text cache: %d KB, %d hits, %d renders",
+                               d.GetCacheBytes() / 1024, d.GetHits(), d.GetMisses()));
+    }
+
+    MyCachedDisplayWindow() {
+        Title("Cached Display Example");
+        SetRect(0, 0, 400, 600);
+        Sizeable().Zoomable();
+
+        header.SetData(MyColorValue(Magenta(), "Magenta Sample"));
+        list.AddColumn("Swatch").SetDisplay(Single<MyColorValueDisplay>());
+        list.AddColumn("Index");
+        for(int i = 0; i < 10000; i++)
+            list.Add(RawToValue(MakeSwatch(i)), i);
+
+        Add(header.TopPos(0, 24).HSizePos());
+        Add(list.VSizePos(24, 24).HSizePos());
+        Add(status.BottomPos(0, 24).HSizePos(4, 4));
+        SetTimeCallback(-500, THISBACK(SyncStatus));
+    }
+};
+
+// Paints 'frames' frames of 60 rows into an ImageDraw, scrolling by 3 rows per frame
+static double ScrollFps(const Display& d, const Vector<Value>& rows, int frames)
+{
+    int row_cy = StdFont().GetCy() + 4;
+    Size sz(300, 60 * row_cy);
+    ImageDraw iw(sz);
+    int64 t0 = usecs();
+    for(int f = 0; f < frames; f++) {
+        int first = f * 3 % (rows.GetCount() - 60);
+        for(int i = 0; i < 60; i++) {
+            bool selected = first + i == 100;
+            d.Paint(iw, RectC(0, i * row_cy, sz.cx, row_cy), rows[first + i],
+                    selected ? SColorHighlightText() : SColorText(),
+                    selected ? SColorHighlight() : SColorPaper(), 0);
+        }
+    }
+    return frames / (usecs(t0) / 1e6);
+}
+
+GUI_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    if(FindIndex(CommandLine(), "--bench") >= 0) {
+        Vector<Value> rows;
+        for(int i = 0; i < 10000; i++)
+            rows.Add(RawToValue(MakeSwatch(i)));
+        MyColorValueDisplay& cached = Single<MyColorValueDisplay>();
+        double plain = ScrollFps(MyColorValuePlainDisplay(), rows, 2000);
+        double cold = ScrollFps(cached, rows, 1);
+        cached.ClearCounters();
+        double warm = ScrollFps(cached, rows, 2000);
+        RLOG(Format("Plain display:  %8.0f frames/s", plain));
+        RLOG(Format("Cached display: %8.0f frames/s (first frame %.0f), %d KB cache, %d hits, %d renders",
+                    warm, cold, cached.GetCacheBytes() / 1024, cached.GetHits(), cached.GetMisses()));
+        return;
+    }
+
+    MyCachedDisplayWindow().Run();
+}
@@ -0,0 +1,249 @@
+#include <Core/Core.h>
+
+using namespace Upp;
+
+// Tracing of CoWork / CoPartition scheduling (compare with MyCoPartitionExample.cpp).
+//
+// Build with the COTRACE flag (mainconfig "" = "COTRACE", or -DflagCOTRACE) to enable it;
+// without the flag the macros expand to nothing, TracedCoWork is plain CoWork and
+// TracedCoPartition is plain CoPartition, so instrumented code costs nothing.
+//
+// With the flag every thread records events into its own buffer (no locking on the hot
+// path, a mutex only when a thread records its first event):
+//
+//  COTRACE_ZONE("name")        scoped zone, a complete event from construction to
+//                              destruction
+//  COTRACE_COUNT("name", n)    per-thread counter sample
+//
+// TracedCoWork records each job as a zone on the thread that ran it, with the queue delay
+// (from scheduling to start) and whether the scheduling thread ran the job itself while
+// waiting in Finish - that is CoWork's equivalent of a steal. TracedCoPartition records
+// every subrange with its bounds and size. CoTraceSave writes everything as Chrome trace
+// JSON (built with Core/JSON.h), which chrome://tracing and ui.perfetto.dev open
+// directly; load imbalance shows up as short tracks, scheduling gaps as holes between jobs.
+
+#ifdef flagCOTRACE
+
+struct CoTraceEvent : Moveable<CoTraceEvent> {
+    const char *name;
+    int64       ts;        // us since the trace start or Clear
+    int64       dur;       // -1 for counters
+    int64       a, b;      // arguments, meaning depends on 'kind'
+    int         kind;
+};
+
+enum { COTRACE_ZONE_EVENT, COTRACE_JOB_EVENT, COTRACE_RANGE_EVENT, COTRACE_COUNTER_EVENT };
+
+class CoTrace : NoCopy {
+    struct ThreadBuffer {
+        int                  id;
+        int                  worker;   // CoWork::GetWorkerIndex() of the thread
+        Vector<CoTraceEvent> event;
+    };
+
+    Mutex               lock;
+    Array<ThreadBuffer> thread;
+    int64               start = usecs();
+
+public:
+    static CoTrace& Get() { return Single<CoTrace>(); }
+
+    int64 Now() const     { return usecs() - start; }
+
+    Vector<CoTraceEvent>& Events() {
+        thread_local ThreadBuffer *b = nullptr;
+        if(!b) {
+            Mutex::Lock __(lock);
+            b = &thread.Add();
+            b->id = thread.GetCount();
+            b->worker = CoWork::GetWorkerIndex();
+        }
+        return b->event;
+    }
+
+    void Add(int kind, const char *name, int64 ts, int64 dur, int64 a = 0, int64 b = 0) {
+        CoTraceEvent& e = Events().Add();
+        e.kind = kind;
+        e.name = name;
+        e.ts = ts;
+        e.dur = dur;
+        e.a = a;
+        e.b = b;
+    }
+
+    // Call when no traced code is running
+    String ToJson() {
+        Mutex::Lock __(lock);
+        JsonArray events;
+        for(const ThreadBuffer& t : thread) {
+            events << Json("name", "thread_name")("ph", "M")("pid", 1)("tid", t.id)
+                          ("args", Json("name", t.worker < 0 ? String("caller " + AsString(t.id))
+                                                             : "worker " + AsString(t.worker)));
+            for(const CoTraceEvent& e : t.event) {
+                Json j;
+                j("name", e.name)("pid", 1)("tid", t.id)("ts", e.ts);
+                switch(e.kind) {
+                case COTRACE_JOB_EVENT:
+                    j("ph", "X")("dur", e.dur)("args", Json("queue_us", e.a)("run_by_waiter", (bool)e.b));
+                    break;
+                case COTRACE_RANGE_EVENT:
+                    j("ph", "X")("dur", e.dur)("args", Json("begin", e.a)("end", e.b)("size", e.b - e.a));
+                    break;
+                case COTRACE_COUNTER_EVENT:
+                    j("ph", "C")("args", Json(e.name, e.a));
+                    break;
+                default:
+                    j("ph", "X")("dur", e.dur);
+                }
+                events << j;
+            }
+        }
+        return Json("traceEvents", events)("displayTimeUnit", "ms");
+    }
+
+    // Per-thread jobs, busy and idle time over the traced span, jobs run by a waiting thread
+    String Summary() {
+        Mutex::Lock __(lock);
+        int64 first = INT64_MAX, last = 0;
+        for(const ThreadBuffer& t : thread)
+            for(const CoTraceEvent& e : t.event) {
+                first = min(first, e.ts);
+                last = max(last, e.ts + max<int64>(e.dur, 0));
+            }
+        int64 span = max<int64>(last - first, 0);
+        String r;
+        for(const ThreadBuffer& t : thread) {
+            int64 busy = 0;
+            int jobs = 0, waiter = 0;
+            for(const CoTraceEvent& e : t.event)
+                if(e.kind == COTRACE_JOB_EVENT || e.kind == COTRACE_RANGE_EVENT) {
+                    busy += e.dur;
+                    jobs++;
+                    waiter += e.kind == COTRACE_JOB_EVENT && e.b;
+                }
+            r << Format("thread %2d (worker %2d): %4d jobs, busy %8d us, idle %8d us, %d run while waiting\n",
+                        t.id, t.worker, jobs, busy, max<int64>(span - busy, 0), waiter);
+        }
+        return r;
+    }
+
+    void Clear() {
+        Mutex::Lock __(lock);
+        for(ThreadBuffer& t : thread)
+            t.event.Clear();
+        start = usecs();
+    }
+};
+
+struct CoTraceZone {
+    const char *name;
+    int64       t0;
+
+    CoTraceZone(const char *name) : name(name), t0(CoTrace::Get().Now()) {}
+    ~CoTraceZone() { CoTrace& t = CoTrace::Get(); t.Add(COTRACE_ZONE_EVENT, name, t0, t.Now() - t0); }
+};
+
+#define COTRACE_ZONE(name)         CoTraceZone COMBINE(cotrace_zone_, __LINE__)(name)
+#define COTRACE_COUNT(name, value) CoTrace::Get().Add(COTRACE_COUNTER_EVENT, name, CoTrace::Get().Now(), -1, (int64)(value))
+
+// CoWork that records every job
+class TracedCoWork : public CoWork {
+    const char *name;
+
+public:
+    TracedCoWork& operator&(Function<void ()> fn) {
+        int64 queued = CoTrace::Get().Now();
+        Thread::Id owner = Thread::GetCurrentId();
+        CoWork::operator&([=, fn = pick(fn)] {
+            CoTrace& t = CoTrace::Get();
+            int64 t0 = t.Now();
+            fn();
+            t.Add(COTRACE_JOB_EVENT, name, t0, t.Now() - t0, t0 - queued, Thread::GetCurrentId() == owner);
+        });
+        return *this;
+    }
+
+    TracedCoWork(const char *name = "job") : name(name) {}
+};
+
+template <class Fn>
+void TracedCoPartition(int begin, int end, const Fn& fn, const char *name = "subrange")
+{
+    CoPartition(begin, end, [&](int lo, int hi) {
+        CoTrace& t = CoTrace::Get();
+        int64 t0 = t.Now();
+        fn(lo, hi);
+        t.Add(COTRACE_RANGE_EVENT, name, t0, t.Now() - t0, lo, hi);
+    });
+}
+
+inline bool CoTraceSave(const String& path) { return SaveFile(path, CoTrace::Get().ToJson()); }
+
+#else
+
+#define COTRACE_ZONE(name)
+#define COTRACE_COUNT(name, value)
+
+struct TracedCoWork : CoWork {
+    TracedCoWork(const char * = NULL) {}
+};
+
+template <class Fn>
+void TracedCoPartition(int begin, int end, const Fn& fn, const char * = NULL)
+{
+    CoPartition(begin, end, fn);
+}
+
+inline bool CoTraceSave(const String&) { return false; }
+
+#endif
+
+CONSOLE_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    // The sum from MyCoPartitionExample.cpp, on skewed data
+    Vector<int> numbers;
+    for(int i = 0; i < 4000000; i++)
+        numbers.Add(i % 1000);
+    std::atomic<int64> total(0);
+    {
+        COTRACE_ZONE("partitioned sum");
+        TracedCoPartition(0, numbers.GetCount(), [&](int lo, int hi) {
+            int64 sum = 0;
+            for(int i = lo; i < hi; i++) {
+                sum += numbers[i];
+                if(i < numbers.GetCount() / 8) // the first eighth is expensive
+                    sum += (int64)sqrt((double)numbers[i]);
+            }
+            total += sum;
+        });
+    }
+    RLOG("Sum: " << (int64)total);
+
+    // Jobs of very different sizes
+    std::atomic<int64> mixed(0);
+    {
+        COTRACE_ZONE("mixed jobs");
+        TracedCoWork co("mixed job");
+        for(int i = 0; i < 64; i++)
+            co & [=, &mixed] {
+                COTRACE_ZONE("busy loop");
+                double acc = 0;
+                for(int k = 0; k < (i % 8 == 0 ? 4000000 : 200000); k++)
+                    acc += sqrt((double)k);
+                COTRACE_COUNT("acc", (int64)acc);
+                mixed += (int64)acc; // keeps the loop observable without flagCOTRACE too
+            };
+        co.Finish();
+    }
+    RLOG("Mixed jobs total: " << (int64)mixed);
+
+#ifdef flagCOTRACE
+    String path = GetExeDirFile("cotrace.json");
+    if(CoTraceSave(path))
+        RLOG("Trace written to " << path << " (open in chrome://tracing or ui.perfetto.dev)");
+    RLOG(CoTrace::Get().Summary());
+#else
+    RLOG("Built without flagCOTRACE: tracing is compiled out");
+#endif
+}
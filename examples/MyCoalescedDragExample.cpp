@@ -0,0 +1,183 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Dragging with coalesced mouse moves (compare with "Safe Dragging Control" and "Drag
+// Math" in UppApplicationSessionGuide.md).
+//
+// The guide's Draggable runs its logic and Refresh() for every mouse event. A 1000 Hz
+// mouse delivers many events per displayed frame, and handling each of them one by one
+// makes the handle trail behind the cursor. DragCoalescer only records the latest
+// position in MouseMove and posts a single apply callback; all moves that arrive before
+// it runs are folded into one. The apply step does the drag math normalisation once and
+// refreshes just the old and the new handle rectangles.
+//
+// Latency is measured from the oldest mouse event folded into an apply to the end of the
+// Paint that shows the result. That is input-to-paint; the compositor and display scanout
+// that follow are not visible to the application.
+
+// Collects mouse positions and calls WhenApply(latest) once per posted callback
+class DragCoalescer {
+    Point   latest;
+    int64   first_event = 0;   // time of the oldest pending move, 0 = nothing pending
+    bool    posted = false;
+    Ctrl   *owner = nullptr;
+
+public:
+    Event<Point> WhenApply;
+
+    int     events = 0;        // statistics
+    int     applies = 0;
+    int64   applied_event = 0; // first_event of the last apply, for latency
+
+    void Move(Point p) {
+        latest = p;
+        events++;
+        if(!first_event)
+            first_event = usecs();
+        if(!posted) {
+            posted = true;
+            owner->PostCallback([=] { Flush(); });
+        }
+    }
+
+    // Applies a pending move right away (LeftUp must not lose the last position)
+    void Flush() {
+        posted = false;
+        if(!first_event)
+            return;
+        applied_event = first_event;
+        first_event = 0;
+        applies++;
+        WhenApply(latest);
+    }
+
+    void Attach(Ctrl& c) { owner = &c; }
+};
+
+class DragPad : public Ctrl {
+    enum { INSET = 6, HANDLE = 14 };
+
+    bool          dragging = false;
+    Pointf        value = Pointf(0.5, 0.5);   // normalised handle position
+    DragCoalescer coalescer;
+    Vector<int>   latency_us;
+    bool          measure = false;            // a new state is waiting for Paint
+
+    Point ToPixels(Pointf v) const {
+        Size sz = GetSize();
+        return Point(INSET + int(v.x * (sz.cx - 2 * INSET) + 0.5),
+                     INSET + int((1.0 - v.y) * (sz.cy - 2 * INSET) + 0.5));
+    }
+
+    Rect HandleRect(Pointf v) const {
+        Point p = ToPixels(v);
+        return RectC(p.x - HANDLE / 2, p.y - HANDLE / 2, HANDLE, HANDLE).Inflated(1);
+    }
+
+    // The guide's drag math, once per coalesced batch
+    void Apply(Point p) {
+        Size sz = GetSize();
+        Pointf nf(clamp((p.x - INSET) / double(sz.cx - 2 * INSET), 0.0, 1.0),
+                  clamp(1.0 - (p.y - INSET) / double(sz.cy - 2 * INSET), 0.0, 1.0));
+        if(nf == value)
+            return;
+        Refresh(HandleRect(value));
+        value = nf;
+        Refresh(HandleRect(value));
+        measure = true;
+        WhenAction();
+    }
+
+public:
+    Event<> WhenStats;
+
+    int GetEvents() const  { return coalescer.events; }
+    int GetApplies() const { return coalescer.applies; }
+    Pointf GetValue() const { return value; }
+
+    void GetLatency(double& p50, double& p99, double& mx) const {
+        Vector<int> v = clone(latency_us);
+        Sort(v);
+        auto at = [&](int p) { return v.GetCount() ? v[min(v.GetCount() - 1, v.GetCount() * p / 100)] / 1000.0 : 0.0; };
+        p50 = at(50);
+        p99 = at(99);
+        mx = v.GetCount() ? v.Top() / 1000.0 : 0.0;
+    }
+
+    virtual void Paint(Draw& w) override {
+        Size sz = GetSize();
+        w.DrawRect(sz, SColorPaper());
+        w.DrawRect(INSET, sz.cy / 2, sz.cx - 2 * INSET, 1, SColorShadow());
+        w.DrawRect(sz.cx / 2, INSET, 1, sz.cy - 2 * INSET, SColorShadow());
+        Rect h = HandleRect(value).Deflated(1);
+        w.DrawRect(h, dragging ? LtRed() : SColorHighlight());
+        if(measure) {
+            measure = false;
+            if(latency_us.GetCount() >= 1000)
+                latency_us.Remove(0, 500);
+            latency_us.Add(int(usecs() - coalescer.applied_event));
+            PostCallback([=] { WhenStats(); }); // not from inside Paint
+        }
+    }
+
+    virtual void LeftDown(Point p, dword) override {
+        dragging = true;
+        SetCapture();
+        coalescer.Move(p);
+        Refresh(HandleRect(value));
+    }
+
+    virtual void LeftUp(Point p, dword) override {
+        coalescer.Move(p);
+        coalescer.Flush();
+        dragging = false;
+        ReleaseCapture();
+        Refresh(HandleRect(value));
+    }
+
+    virtual void MouseMove(Point p, dword) override {
+        if(!dragging)
+            return;
+        if(!GetMouseLeft()) {
+            dragging = false;
+            ReleaseCapture();
+            Refresh(HandleRect(value));
+            return;
+        }
+        coalescer.Move(p); // no logic, no Refresh here
+    }
+
+    DragPad() {
+        coalescer.Attach(*this);
+        coalescer.WhenApply = [=](Point p) { Apply(p); };
+    }
+};
+
+struct MyCoalescedDragWindow : TopWindow {
+    DragPad pad;
+    Label   stats;
+
+    void SyncStats() {
+        double p50, p99, mx;
+        pad.GetLatency(p50, p99, mx);
+        Pointf v = pad.GetValue();
+        stats.SetLabel(Format("value %.3f, %.3f | %d mouse events -> %d updates | "
+                              "input-to-paint p50 %.2f ms, p99 %.2f ms, max %.2f ms",
+                              v.x, v.y, pad.GetEvents(), pad.GetApplies(), p50, p99, mx));
+    }
+
+    MyCoalescedDragWindow() {
+        Title("Coalesced Drag Example");
+        SetRect(0, 0, 640, 480);
+        Sizeable().Zoomable();
+        Add(pad.VSizePos(0, 24).HSizePos());
+        Add(stats.BottomPos(0, 24).HSizePos(4, 4));
+        pad.WhenStats = [=] { SyncStats(); };
+        SyncStats();
+    }
+};
+
+GUI_APP_MAIN {
+    MyCoalescedDragWindow().Run();
+}
@@ -0,0 +1,221 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Columnar backing store for ArrayCtrl (compare with MyArrayCtrlExample.cpp).
+//
+// dataList.Add(1, "Alice") keeps a Vector<Value> per row, so every cell is a separate
+// boxed Value and every Set(row, "Name", ...) resolves the column id by name. Here the
+// data lives in typed columns instead: a Vector<int> for "ID" and a string pool (one
+// character buffer plus offsets) for "Name". The ArrayCtrl runs in virtual mode with
+// row-number columns, and a per-column Display reads the raw column and draws it when
+// the cell is painted; no Value is created per cell.
+//
+// Sorting permutes a Vector<int> of row indices using the raw column data.
+//
+// Run with "--bench" to compare resident memory per row and sort time against the
+// Value-based ArrayCtrl.
+
+// All strings of a column packed into one buffer. String i is
+// data[offset[i], offset[i + 1]).
+class StringColumn {
+    String      data;
+    Vector<int> offset;
+
+public:
+    void        Add(const char *s, int len) { data.Cat(s, len); offset.Add(data.GetCount()); }
+    void        Add(const String& s)        { Add(s, s.GetCount()); }
+    int         GetCount() const            { return offset.GetCount() - 1; }
+    const char *Begin(int i) const          { return ~data + offset[i]; }
+    int         GetLength(int i) const      { return offset[i + 1] - offset[i]; }
+    String      Get(int i) const            { return String(Begin(i), GetLength(i)); }
+
+    // Raw byte comparison, no String is created
+    int Compare(int a, int b) const {
+        int la = GetLength(a), lb = GetLength(b);
+        int q = memcmp(Begin(a), Begin(b), min(la, lb));
+        return q ? q : la - lb;
+    }
+
+    void Reserve(int count, int chars)      { offset.Reserve(count + 1); data.Reserve(chars); }
+    void Shrink()                           { offset.Shrink(); data.Shrink(); }
+    void Clear()                            { data.Clear(); offset.Clear(); offset.Add(0); }
+
+    StringColumn()                          { offset.Add(0); }
+};
+
+// Typed columns of the trade table
+struct TradeColumns {
+    Vector<int>  id;
+    StringColumn name;
+
+    int GetCount() const { return id.GetCount(); }
+};
+
+// Paints one column of TradeColumns. ArrayCtrl passes the display row number; the
+// Display maps it through the sort permutation and draws the raw value.
+class TradeColumnDisplay : public Display {
+public:
+    const TradeColumns *columns = nullptr;
+    const Vector<int>  *order = nullptr;
+    int                 column = 0;
+
+    virtual void Paint(Draw& w, const Rect& r, const Value& q,
+                       Color ink, Color paper, dword style) const {
+        w.DrawRect(r, paper);
+        if(IsNull(q))
+            return;
+        int row = (*order)[(int)q];
+        Font font = StdFont();
+        int x = r.left + 2;
+        int y = r.top + (r.GetHeight() - font.GetCy()) / 2;
+        if(column == 0) {
+            char h[16];
+            int n = sprintf(h, "%d", columns->id[row]);
+            w.DrawText(x, y, h, font, ink, n);
+        }
+        else
+            w.DrawText(x, y, columns->name.Begin(row), font, ink, columns->name.GetLength(row));
+    }
+};
+
+// Synthetic data source standing in for a trade log
+static String TradeName(int i) {
+    static const char *names[] = { "Alice", "Bob", "Charlie", "David" };
+    return Format("%s #%d", names[i % 4], (i * 7919) % 1000003);
+}
+
+// Bulk-loads columns the way a loader would: fill local vectors, then move them in
+static TradeColumns MakeTradeColumns(int rows) {
+    TradeColumns c;
+    c.id.SetCount(rows);
+    c.name.Reserve(rows, rows * 12);
+    for(int i = 0; i < rows; i++) {
+        c.id[i] = rows - i;
+        c.name.Add(TradeName(i));
+    }
+    c.name.Shrink();
+    return c;
+}
+
+// Main window, same columns as MyArrayCtrlWindow but backed by TradeColumns
+class MyColumnarArrayCtrlWindow : public TopWindow {
+public:
+    typedef MyColumnarArrayCtrlWindow CLASSNAME;
+
+    ArrayCtrl          dataList;
+    TradeColumns       columns;
+    Vector<int>        order;       // display row -> column row
+    TradeColumnDisplay idDisplay, nameDisplay;
+    int                sortColumn = -1;
+    bool               sortDescending = false;
+
+    // Takes ownership of the columns, no per-row copies
+    void Load(TradeColumns&& data) {
+        columns = pick(data);
+        order.SetCount(columns.GetCount());
+        for(int i = 0; i < order.GetCount(); i++)
+            order[i] = i;
+        sortColumn = -1;
+        dataList.SetVirtualCount(columns.GetCount());
+        dataList.Refresh();
+    }
+
+    void SortBy(int column) {
+        sortDescending = sortColumn == column && !sortDescending;
+        sortColumn = column;
+        bool desc = sortDescending;
+        const TradeColumns& c = columns;
+        if(column == 0)
+            Sort(order, [&](int a, int b) { return desc ? c.id[a] > c.id[b] : c.id[a] < c.id[b]; });
+        else
+            Sort(order, [&](int a, int b) {
+                int q = c.name.Compare(a, b);
+                return desc ? q > 0 : q < 0;
+            });
+        dataList.Refresh();
+    }
+
+    // 'rows' of demo data are loaded, none with 0 (the benchmark loads its own)
+    MyColumnarArrayCtrlWindow(int rows = 1000000) {
+        Title("Columnar ArrayCtrl Example");
+        SetRect(0, 0, 400, 300);
+        Sizeable().Zoomable();
+
+        idDisplay.columns = nameDisplay.columns = &columns;
+        idDisplay.order = nameDisplay.order = &order;
+        idDisplay.column = 0;
+        nameDisplay.column = 1;
+
+        dataList.AddRowNumColumn("ID", 50).SetDisplay(idDisplay);
+        dataList.AddRowNumColumn("Name", 150).SetDisplay(nameDisplay).HeaderTab().AlignCenter();
+        dataList.HeaderTab(0).WhenAction = [=] { SortBy(0); };
+        dataList.HeaderTab(1).WhenAction = [=] { SortBy(1); };
+        dataList.MultiSelect();
+        dataList.SetLineCy(20);
+
+        if(rows)
+            Load(MakeTradeColumns(rows));
+
+        Add(dataList.SizePos());
+    }
+};
+
+// Benchmark: resident memory per row and sort time, Value cells versus raw columns
+static void BenchmarkColumns(int rows)
+{
+    RLOG("---- " << rows << " rows");
+    double value_bytes;
+    {
+        int mem0 = MemoryUsedKb();
+        ArrayCtrl list;
+        list.AddColumn("ID", 50);
+        list.AddColumn("Name", 150);
+        for(int i = 0; i < rows; i++)
+            list.Add(rows - i, TradeName(i));
+        value_bytes = 1024.0 * (MemoryUsedKb() - mem0) / rows;
+
+        // What sorting Value cells costs: every comparison goes through StdValueCompare
+        Vector<Value> cells;
+        cells.SetCount(rows);
+        for(int i = 0; i < rows; i++)
+            cells[i] = list.Get(i, 1);
+        Vector<int> perm;
+        perm.SetCount(rows);
+        for(int i = 0; i < rows; i++)
+            perm[i] = i;
+        int64 t0 = usecs();
+        Sort(perm, [&](int a, int b) { return StdValueCompare(cells[a], cells[b]) < 0; });
+        RLOG(Format("Value cells:  %6.1f bytes/row, name sort %8.1f ms",
+                    value_bytes, usecs(t0) / 1000.0));
+    }
+    {
+        int mem0 = MemoryUsedKb();
+        MyColumnarArrayCtrlWindow win(0);
+        int64 t0 = usecs();
+        win.Load(MakeTradeColumns(rows));
+        int64 t_load = usecs(t0);
+        double column_bytes = 1024.0 * (MemoryUsedKb() - mem0) / rows;
+        t0 = usecs();
+        win.SortBy(1);
+        int64 t_sort = usecs(t0);
+        t0 = usecs();
+        win.SortBy(0);
+        int64 t_sort_id = usecs(t0);
+        RLOG(Format("Raw columns:  %6.1f bytes/row, name sort %8.1f ms, id sort %.1f ms, load %.1f ms",
+                    column_bytes, t_sort / 1000.0, t_sort_id / 1000.0, t_load / 1000.0));
+        RLOG(Format("Memory reduction: %.1fx", value_bytes / max(column_bytes, 1.0)));
+    }
+}
+
+// Main function for the GUI application
+GUI_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    if(FindIndex(CommandLine(), "--bench") >= 0) {
+        BenchmarkColumns(1000000);
+        return;
+    }
+
+    MyColumnarArrayCtrlWindow().Run();
+}
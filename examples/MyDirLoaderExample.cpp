@@ -0,0 +1,190 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Incremental, cancellable directory listing for FileList (compare with
+// ImageView::LoadDir in UppApplicationSessionGuide.md).
+//
+// ::Load(files, dir, "*.*") followed by SortByExt(files) blocks the GUI thread until the
+// whole directory is enumerated, which on a slow network share can take very long. Here a
+// worker thread walks the directory with FindFile and hands over batches; the GUI thread
+// sorts each batch, merges it into the already sorted entries and refills the FileList,
+// keeping the cursor on the same file. Batches double in size up to a limit and are also
+// sent at least every 100 ms, so the first entries show up at once. Received entries are
+// only merged and shown when they at least double the list (or the listing ends), so
+// the number of refills stays logarithmic and the total work O(n log n), however
+// slowly the share delivers.
+//
+// Navigating away (DoDir, DirUpClick) cancels the listing: the worker checks the flag for
+// every entry (a relaxed atomic, no lock), and batches of an old listing are dropped. The
+// worker thread is detached, so a FindFile call stuck on the network never blocks the GUI;
+// the window only has to make sure it does not post into a destroyed window, which the
+// lock around the flag guarantees.
+
+struct DirEntry : Moveable<DirEntry> {
+    String name;
+    bool   isdir;
+    int64  length;
+    Time   time;
+};
+
+// Same order as SortByExt: folders first, then by extension, then by name
+static bool DirEntryLess(const DirEntry& a, const DirEntry& b)
+{
+    if(a.isdir != b.isdir)
+        return a.isdir;
+    if(!a.isdir) {
+        int q = CompareNoCase(GetFileExt(a.name), GetFileExt(b.name));
+        if(q)
+            return q < 0;
+    }
+    return CompareNoCase(a.name, b.name) < 0;
+}
+
+// State shared by the GUI and one listing worker
+struct DirListing {
+    String            dir;
+    Mutex             lock;
+    bool              canceled = false;   // under lock
+    std::atomic<bool> stop{false};        // same as canceled, polled by the worker per entry
+    bool              posted = false;     // under lock, a merge callback is pending
+    bool              finished = false;   // under lock
+    Vector<DirEntry>  pending;            // under lock
+    int               started = msecs();
+};
+
+class DirBrowser : public TopWindow {
+    FileList         files;
+    String           dir;
+    FrameTop<Button> dirUp;
+    StatusBar        status;
+
+    std::shared_ptr<DirListing> listing;
+    Vector<DirEntry>            entries; // sorted, mirrors 'files'
+    Vector<DirEntry>            incoming; // received, not merged yet
+
+    void Cancel() {
+        if(listing) {
+            Mutex::Lock __(listing->lock);
+            listing->canceled = true;
+            listing->stop.store(true, std::memory_order_relaxed);
+        }
+        listing.reset();
+    }
+
+    // Worker: enumerates the directory and hands over batches of growing size
+    void List(std::shared_ptr<DirListing> l) {
+        Vector<DirEntry> batch;
+        int limit = 256;
+        int last = msecs();
+        FindFile ff(AppendFileName(l->dir, "*.*"));
+        for(bool more = (bool)ff; ; more = ff.Next()) {
+            if(l->stop.load(std::memory_order_relaxed))
+                return; // the lock below still guards the post
+            if(more && (ff.IsFolder() || ff.IsFile()) && ff.GetName() != "." && ff.GetName() != "..") {
+                DirEntry& e = batch.Add();
+                e.name = ff.GetName();
+                e.isdir = ff.IsFolder();
+                e.length = ff.GetLength();
+                e.time = ff.GetLastWriteTime();
+            }
+            if(!more || batch.GetCount() >= limit || msecs(last) > 100) {
+                Mutex::Lock __(l->lock);
+                if(l->canceled)
+                    return;
+                l->pending.AppendPick(pick(batch));
+                batch.Clear();
+                l->finished = !more;
+                if(!l->posted) {
+                    l->posted = true;
+                    PostCallback([=] { Merge(l); });
+                }
+                limit = min(2 * limit, 32768);
+                last = msecs();
+            }
+            if(!more)
+                return;
+        }
+    }
+
+    // GUI thread: collects the pending batch; merges into 'entries' and refills the list
+    // once the collected entries double the list
+    void Merge(std::shared_ptr<DirListing> l) {
+        if(l != listing)
+            return; // navigated away
+        bool finished;
+        {
+            Mutex::Lock __(l->lock);
+            incoming.AppendPick(pick(l->pending));
+            l->pending.Clear();
+            l->posted = false;
+            finished = l->finished;
+        }
+        if(!finished && entries.GetCount() && incoming.GetCount() < entries.GetCount()) {
+            status.Set(Format("%d entries, listing... (%d ms)", entries.GetCount() + incoming.GetCount(),
+                              msecs(l->started)));
+            return;
+        }
+        Vector<DirEntry> batch = pick(incoming);
+        incoming.Clear();
+        Sort(batch, DirEntryLess);
+        Vector<DirEntry> merged;
+        merged.Reserve(entries.GetCount() + batch.GetCount());
+        int i = 0, j = 0;
+        while(i < entries.GetCount() || j < batch.GetCount())
+            if(j >= batch.GetCount() || (i < entries.GetCount() && !DirEntryLess(batch[j], entries[i])))
+                merged.Add(pick(entries[i++]));
+            else
+                merged.Add(pick(batch[j++]));
+        entries = pick(merged);
+
+        String cursor = files.IsCursor() ? files.GetCurrentName() : String();
+        files.Clear();
+        for(const DirEntry& e : entries)
+            files.Add(e.name, e.isdir ? CtrlImg::Dir() : CtrlImg::File(), StdFont(), SColorText(),
+                      e.isdir, e.length, e.time);
+        if(cursor.GetCount()) {
+            int q = files.Find(cursor);
+            if(q >= 0)
+                files.SetCursor(q);
+        }
+        status.Set(Format("%d entries%s (%d ms)", entries.GetCount(), finished ? "" : ", listing...",
+                          msecs(l->started)));
+        if(finished)
+            listing.reset();
+    }
+
+    void LoadDir(const String& d) {
+        Cancel();
+        dir = d; files.Clear(); entries.Clear(); incoming.Clear(); Title(dir);
+        listing = std::make_shared<DirListing>();
+        listing->dir = dir;
+        status.Set("Listing...");
+        std::shared_ptr<DirListing> l = listing;
+        Thread::Start([=] { List(l); });
+    }
+
+    void DoDir()       { if(files.IsCursor() && files.Get(files.GetCursor()).isdir)
+                           LoadDir(AppendFileName(dir, files.GetKey())); }
+    void DirUpClick()  { LoadDir(DirectoryUp(dir)); }
+
+public:
+    typedef DirBrowser CLASSNAME;
+    DirBrowser() {
+        Title("Directory browser"); Sizeable().Zoomable();
+        SetRect(0, 0, 600, 700);
+        Add(files.SizePos());
+        AddFrame(status);
+        files.WhenLeftDouble = THISBACK(DoDir);
+        dirUp.SetImage(CtrlImg::DirUp()).NormalStyle();
+        dirUp <<= THISBACK(DirUpClick);
+        files.AddFrame(dirUp);
+        LoadDir(GetCurrentDirectory());
+    }
+    ~DirBrowser() {
+        Cancel(); // after this the worker no longer posts, pending posts die with the Ctrl
+    }
+    virtual bool Key(dword k, int) override { return k==K_ENTER && (DoDir(), true); }
+};
+
+GUI_APP_MAIN { DirBrowser().Run(); }
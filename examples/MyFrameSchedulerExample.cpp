@@ -0,0 +1,215 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Frame scheduler for animations (compare with "Manual Timing" in
+// UppApplicationSessionGuide.md).
+//
+// The guide's manual tick reads msecs(), clamps dt and runs one frame per timer event, so
+// the animation speed follows the timer jitter at millisecond resolution. FrameScheduler
+// times frames with usecs() and separates simulation from rendering:
+//
+//  - the simulation advances in fixed steps (WhenStep, 1/120 s by default), as many as
+//    the elapsed time requires, with a cap on catch-up steps after a stall
+//  - WhenRender gets the fraction of a step left over, so the view interpolates between
+//    the last two simulation states and motion stays smooth at any frame rate
+//  - low priority work queued with Defer runs after rendering, only while the frame is
+//    within its budget; whatever does not fit waits for the next frame
+//  - the next frame is scheduled for the next deadline instead of a fixed timer period
+//
+// GetStats reports p50/p99 of the frame interval and of the work per frame and how many
+// frames missed their deadline.
+
+class FrameScheduler {
+    TimeCallback               timer;
+    int64                      period;        // frame interval, us
+    int64                      step;          // simulation step, us
+    int64                      budget;        // work per frame before deferring, us
+    int                        max_steps = 8;
+    int64                      last = 0;      // simulation time consumed up to here
+    int64                      next = 0;      // deadline of the next frame
+    int64                      prev_start = 0;
+    BiVector<Function<void ()>> deferred;
+    Vector<int>                interval_us;   // rings of recent frames
+    Vector<int>                work_us;
+    int                        ring = 0;
+    int                        missed = 0;
+    int                        frames = 0;
+    bool                       running = false;
+
+    void Schedule() {
+        int64 now = usecs();
+        timer.KillSet(int(max<int64>(next - now, 0) / 1000), [=] { Tick(); });
+    }
+
+    void Tick() {
+        int64 start = usecs();
+        if(start + 500 < next) { // woke up early, the timer only has ms resolution
+            Schedule();
+            return;
+        }
+        if(prev_start) {
+            int iv = int(start - prev_start);
+            if(start > next + period / 2)
+                missed++;
+            Record(interval_us, iv);
+        }
+        prev_start = start;
+
+        int steps = 0;
+        while(start - last >= step && steps < max_steps) {
+            WhenStep(step / 1e6);
+            last += step;
+            steps++;
+        }
+        if(start - last >= step)
+            last = start - step + 1; // stalled too long, drop the backlog instead of fast-forwarding
+        WhenRender(double(start - last) / step);
+
+        while(deferred.GetCount() && usecs() - start < budget)
+            deferred.PopHead()();
+
+        Record(work_us, int(usecs() - start));
+        ring++;
+        frames++;
+        next += period;
+        if(next < start)
+            next = start + period; // do not try to catch up missed frames
+        if(running)
+            Schedule();
+    }
+
+    void Record(Vector<int>& v, int x) {
+        if(v.GetCount() < 240)
+            v.Add(x);
+        else
+            v[ring % 240] = x;
+    }
+
+    static double Percentile(Vector<int> v, int p) {
+        if(v.IsEmpty())
+            return 0;
+        Sort(v);
+        return v[min(v.GetCount() - 1, v.GetCount() * p / 100)] / 1000.0;
+    }
+
+public:
+    Event<double> WhenStep;   // advance the simulation by dt seconds
+    Event<double> WhenRender; // draw the state interpolated by alpha in [0, 1)
+
+    struct Stats {
+        double interval_p50, interval_p99;  // ms
+        double work_p50, work_p99;          // ms
+        int    missed, frames, deferred;
+    };
+
+    void Start() {
+        running = true;
+        last = usecs();
+        next = last + period;
+        prev_start = 0;
+        Schedule();
+    }
+
+    void Stop()                          { running = false; timer.Kill(); }
+
+    // Queues low priority work for the remaining budget of this or a later frame
+    void Defer(Function<void ()> fn)     { deferred.AddTail(pick(fn)); }
+    int  GetDeferredCount() const        { return deferred.GetCount(); }
+
+    Stats GetStats() const {
+        Stats s;
+        s.interval_p50 = Percentile(clone(interval_us), 50);
+        s.interval_p99 = Percentile(clone(interval_us), 99);
+        s.work_p50 = Percentile(clone(work_us), 50);
+        s.work_p99 = Percentile(clone(work_us), 99);
+        s.missed = missed;
+        s.frames = frames;
+        s.deferred = deferred.GetCount();
+        return s;
+    }
+
+    FrameScheduler& Fps(int fps)         { period = 1000000 / fps; return *this; }
+    FrameScheduler& StepRate(int hz)     { step = 1000000 / hz; return *this; }
+    FrameScheduler& Budget(int us)       { budget = us; return *this; }
+
+    FrameScheduler() : period(1000000 / 60), step(1000000 / 120), budget(10000) {}
+};
+
+struct Needle {
+    double angle = 0, velocity = 0;     // current simulation state
+    double prev_angle = 0;              // state before the last step
+};
+
+struct MyFrameSchedulerWindow : TopWindow {
+    typedef MyFrameSchedulerWindow CLASSNAME;
+
+    FrameScheduler    scheduler;
+    Array<Needle>     needles;
+    double            alpha = 0;
+    Vector<double>    history;          // filled by deferred work
+    int               jobs_done = 0;
+
+    void Step(double dt) {
+        for(int i = 0; i < needles.GetCount(); i++) {
+            Needle& n = needles[i];
+            n.prev_angle = n.angle;
+            n.velocity += (sin(i + n.angle * 3) - n.angle) * dt * 4; // a damped, wobbling gauge
+            n.velocity *= 0.995;
+            n.angle += n.velocity * dt;
+        }
+    }
+
+    void Render(double a) {
+        alpha = a;
+        Refresh();
+        Sync(); // paint now, so the frame work includes it
+        // recompute some history in the remaining budget; topping up to 3 waiting jobs
+        // instead of adding 3 per frame keeps the queue from growing in busy frames
+        for(int i = scheduler.GetDeferredCount(); i < 3; i++)
+            scheduler.Defer([=] {
+                int64 t0 = usecs();
+                double acc = 0;
+                while(usecs(t0) < 1500)
+                    acc += sqrt(acc + 1);
+                history.Add(acc);
+                if(history.GetCount() > 100)
+                    history.Remove(0);
+                jobs_done++;
+            });
+    }
+
+    virtual void Paint(Draw& w) override {
+        Size sz = GetSize();
+        w.DrawRect(sz, SColorPaper());
+        int cols = 8, cell = min(sz.cx / cols, (sz.cy - 60) / 4);
+        for(int i = 0; i < needles.GetCount(); i++) {
+            const Needle& n = needles[i];
+            double a = n.prev_angle + (n.angle - n.prev_angle) * alpha; // interpolated
+            Point c(cell * (i % cols) + cell / 2, 60 + cell * (i / cols) + cell / 2);
+            int r = cell / 2 - 6;
+            w.DrawEllipse(c.x - r, c.y - r, 2 * r, 2 * r, SColorFace(), 1, SColorShadow());
+            w.DrawLine(c, Point(int(c.x + r * sin(a) + 0.5), int(c.y - r * cos(a) + 0.5)), 3, LtRed());
+        }
+        FrameScheduler::Stats s = scheduler.GetStats();
+        w.DrawText(8, 8, Format("interval p50 %.2f ms, p99 %.2f ms; work p50 %.2f ms, p99 %.2f ms",
+                                s.interval_p50, s.interval_p99, s.work_p50, s.work_p99), StdFont(), SColorText());
+        w.DrawText(8, 30, Format("%d frames, %d missed deadlines, %d deferred jobs done, %d waiting",
+                                 s.frames, s.missed, jobs_done, s.deferred), StdFont(), SColorText());
+    }
+
+    MyFrameSchedulerWindow() {
+        Title("Frame Scheduler Example");
+        SetRect(0, 0, 800, 500);
+        Sizeable().Zoomable();
+        for(int i = 0; i < 32; i++)
+            needles.Add().angle = i * 0.2;
+        scheduler.WhenStep = THISBACK(Step);
+        scheduler.WhenRender = THISBACK(Render);
+        scheduler.Fps(60).StepRate(120).Budget(8000).Start();
+    }
+};
+
+GUI_APP_MAIN {
+    MyFrameSchedulerWindow().Run();
+}
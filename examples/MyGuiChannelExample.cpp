@@ -0,0 +1,311 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Background results marshalled to the GUI thread without GuiLock (compare with
+// MyColorButtonWindow::ColorChanged in MyColorButtonExample.cpp and "Threading" in
+// UppApplicationSessionGuide.md).
+//
+// ColorChanged updates a Label from the GUI thread. Background jobs that do the same
+// take GuiLock around every SetLabel / SetColor, so each update competes with painting
+// and input handling for the GUI mutex, and a fast producer can keep the GUI thread
+// waiting for its own lock. GuiChannel is a lock-free multiple producer / single
+// consumer queue of GuiSlots instead:
+//
+//  - a GuiSlot is one update target (a control, or one property of it) and holds only
+//    the latest update posted to it
+//  - producers (CoWork jobs, Threads) Post an apply function to a slot; Post swaps it in
+//    with one atomic exchange and drops the update it replaced. Only a slot that goes
+//    from clean to dirty is queued, so the queue never holds more entries than there are
+//    slots, however fast the producers run
+//  - once per frame the GUI thread takes the queued slots and applies their latest
+//    updates in order until the frame budget is used up; the rest waits for the next
+//    frame and keeps absorbing newer updates meanwhile
+//
+// Run with "--bench" to compare frame times and producer throughput with GuiLock updates
+// and with the channel.
+
+class GuiChannel;
+
+// Slots are owned by the client and have to outlive the channel they post to
+class GuiSlot : NoCopy {
+    struct Update {
+        Function<void ()> apply;
+    };
+
+    std::atomic<GuiSlot *> next;
+    std::atomic<Update *>  latest;     // nullptr = clean
+
+    friend class GuiChannel;
+
+public:
+    GuiSlot()  { next = nullptr; latest = nullptr; }
+    ~GuiSlot() { delete latest.load(); }
+};
+
+class GuiChannel : NoCopy {
+    std::atomic<GuiSlot *> head;               // producers push here
+    byte                   pad[64];
+    GuiSlot               *tail;               // GUI thread only
+    GuiSlot                stub;
+    Vector<GuiSlot *>      ready;              // dequeued, not applied yet, GUI thread only
+    TimeCallback           timer;
+    int64                  budget = 2000;      // us of apply work per frame
+    std::atomic<int64>     posted;
+    std::atomic<int64>     coalesced;
+    int64                  applied = 0;        // statistics, GUI thread only
+    int64                  frames = 0;
+    int                    max_drain = 0;
+
+    void Enqueue(GuiSlot *n) {
+        n->next.store(nullptr, std::memory_order_relaxed);
+        GuiSlot *prev = head.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release); // until this store the consumer sees the end of the list
+    }
+
+    // Vyukov's intrusive MPSC queue; nullptr when empty or a producer is half way through Enqueue
+    GuiSlot *Dequeue() {
+        GuiSlot *t = tail;
+        GuiSlot *next = t->next.load(std::memory_order_acquire);
+        if(t == &stub) {
+            if(!next)
+                return nullptr;
+            tail = t = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if(next) {
+            tail = next;
+            return t;
+        }
+        if(t != head.load(std::memory_order_acquire))
+            return nullptr;
+        Enqueue(&stub);
+        next = t->next.load(std::memory_order_acquire);
+        if(next) {
+            tail = next;
+            return t;
+        }
+        return nullptr;
+    }
+
+public:
+    // Any thread
+    void Post(GuiSlot& slot, Function<void ()>&& apply) {
+        GuiSlot::Update *u = new GuiSlot::Update;
+        u->apply = pick(apply);
+        posted.fetch_add(1, std::memory_order_relaxed);
+        if(GuiSlot::Update *old = slot.latest.exchange(u, std::memory_order_acq_rel)) {
+            delete old; // not applied yet, the slot is already queued
+            coalesced.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+            Enqueue(&slot);
+    }
+
+    // GUI thread: applies the latest update of queued slots while the budget lasts
+    void Drain() {
+        int64 t0 = usecs();
+        while(GuiSlot *q = Dequeue())
+            ready.Add(q); // at most one entry per slot
+        int i = 0;
+        while(i < ready.GetCount() && (i == 0 || usecs() - t0 < budget)) {
+            // from here on a Post queues the slot again
+            GuiSlot::Update *u = ready[i++]->latest.exchange(nullptr, std::memory_order_acq_rel);
+            if(u) {
+                u->apply();
+                delete u;
+                applied++;
+            }
+        }
+        ready.Remove(0, i);
+        frames++;
+        max_drain = max(max_drain, int(usecs() - t0));
+    }
+
+    void Start(int frame_ms = 16)  { timer.KillSet(-frame_ms, [=] { Drain(); }); }
+    void Stop()                    { timer.Kill(); }
+    void SetBudget(int us)         { budget = us; }
+
+    int64 GetPosted() const        { return posted.load(std::memory_order_relaxed); }
+    int64 GetCoalesced() const     { return coalesced.load(std::memory_order_relaxed); }
+    int64 GetApplied() const       { return applied; }
+    int64 GetFrames() const        { return frames; }
+    int   GetPending() const       { return ready.GetCount(); }
+    int   GetMaxDrainUs() const    { return max_drain; }
+    void  ResetStats()             { posted = 0; coalesced = 0; applied = frames = 0; max_drain = 0; }
+
+    GuiChannel() {
+        head = tail = &stub;
+        posted = 0;
+        coalesced = 0;
+    }
+
+    // Producers have to be stopped before the channel goes away; pending updates are
+    // freed with their slots
+    ~GuiChannel() {
+        timer.Kill();
+    }
+};
+
+class MyGuiChannelWindow : public TopWindow {
+public:
+    typedef MyGuiChannelWindow CLASSNAME;
+
+    enum { CELLS = 32 };
+
+    Label              cell[CELLS];
+    ColorButton        colorBtn;
+    Option             useLock;
+    Label              status;
+    GuiSlot            cellSlot[CELLS];
+    GuiSlot            colorSlot;
+    GuiChannel         channel;        // after the slots: they outlive it
+    std::atomic<bool>  stop;
+    std::atomic<bool>  guiLock;        // update through GuiLock, the "before" case
+    std::atomic<int64> updates;
+    int64              lastUpdates = 0, lastApplied = 0;
+    CoWork             work;           // declared last: jobs finish before the cells go away
+
+    // A few microseconds of "computation" per result
+    static double Simulate(int i, int64 iter) {
+        double x = i + 0.001 * iter;
+        for(int k = 0; k < 100; k++)
+            x = sin(x) + 0.5 * cos(x * 0.5 + k);
+        return x;
+    }
+
+    void Set(int i, const String& text) {
+        if(guiLock) {
+            GuiLock __;
+            cell[i].SetLabel(text);
+        }
+        else
+            channel.Post(cellSlot[i], [=] { cell[i].SetLabel(text); });
+    }
+
+    void SetColor(Color c) {
+        if(guiLock) {
+            GuiLock __;
+            colorBtn.SetColor(c);
+        }
+        else
+            channel.Post(colorSlot, [=] { colorBtn.SetColor(c); });
+    }
+
+    // Producer p of n: recomputes cells p, p + n, p + 2n ... until stopped
+    void Produce(int p, int n) {
+        for(int64 iter = 0; !stop; iter++) {
+            for(int i = p; i < CELLS; i += n) {
+                Set(i, Format("Cell %d: %.4f", i, Simulate(i, iter)));
+                updates.fetch_add(1, std::memory_order_relaxed);
+            }
+            if(p == 0)
+                SetColor(Color(byte(iter), byte(iter >> 2), byte(255 - iter)));
+        }
+    }
+
+    void StartProducers() {
+        stop = false;
+        int n = CPU_Cores();
+        for(int p = 0; p < n; p++)
+            work & [=] { Produce(p, n); };
+    }
+
+    void StopProducers() {
+        stop = true;
+        GuiUnlock __; // producers in GuiLock mode may be waiting for this thread
+        work.Finish();
+    }
+
+    void Mode() {
+        StopProducers();
+        guiLock = useLock.Get();
+        StartProducers();
+    }
+
+    void Stats() {
+        int64 u = updates, a = channel.GetApplied();
+        status.SetLabel(Format("%d updates/s, %d applied/s, %d pending, max drain %d us",
+                               u - lastUpdates, a - lastApplied, channel.GetPending(), channel.GetMaxDrainUs()));
+        lastUpdates = u;
+        lastApplied = a;
+    }
+
+    MyGuiChannelWindow() {
+        Title("GUI Channel Example");
+        SetRect(0, 0, 520, 460);
+        stop = false;
+        guiLock = false;
+        updates = 0;
+
+        for(int i = 0; i < CELLS; i++)
+            Add(cell[i].SetLabel(Format("Cell %d", i)).LeftPos(10 + i / 16 * 250, 240).TopPos(10 + i % 16 * 22, 20));
+        Add(colorBtn.LeftPos(10, 100).BottomPos(40, 24));
+        Add(useLock.SetLabel("Update through GuiLock").LeftPos(120, 200).BottomPos(40, 24));
+        Add(status.HSizePos(10, 10).BottomPos(10, 20));
+        useLock << THISBACK(Mode);
+
+        channel.Start();
+        SetTimeCallback(-1000, THISBACK(Stats));
+        StartProducers();
+    }
+
+    ~MyGuiChannelWindow() {
+        StopProducers();
+    }
+};
+
+static int Percentile(Vector<int>& v, int p)
+{
+    if(v.IsEmpty())
+        return 0;
+    Sort(v);
+    return v[min(v.GetCount() - 1, v.GetCount() * p / 100)];
+}
+
+// Runs 'seconds' of 60 Hz frames with the producers going: the GUI thread sleeps with
+// the GUI mutex released like in the event loop, then drains the channel and paints
+static void BenchMode(MyGuiChannelWindow& win, bool lock, int seconds)
+{
+    ImageDraw iw(win.GetSize());
+    win.StopProducers();
+    win.guiLock = lock;
+    win.updates = 0;
+    win.channel.ResetStats();
+    Vector<int> frame_us;
+    int64 t0 = usecs();
+    win.StartProducers();
+    while(usecs(t0) < seconds * 1000000) {
+        int64 wake;
+        {
+            GuiUnlock __;
+            Sleep(16);
+            wake = usecs();
+        } // GuiLock producers compete for the mutex here
+        win.channel.Drain();
+        win.DrawCtrl(iw);
+        frame_us.Add(int(usecs() - wake));
+    }
+    win.StopProducers();
+    double s = usecs(t0) / 1e6;
+    RLOG(Format("%-8s %10.0f updates/s %8.0f applied/s, frame p50 %6d us p99 %6d us max %6d us",
+                lock ? "GuiLock" : "Channel", win.updates / s, win.channel.GetApplied() / s,
+                Percentile(frame_us, 50), Percentile(frame_us, 99), Percentile(frame_us, 100)));
+}
+
+GUI_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    if(FindIndex(CommandLine(), "--bench") >= 0) {
+        MyGuiChannelWindow win;
+        win.channel.Stop(); // drained by BenchMode instead of the timer
+        RLOG(Format("%d producers, %d cells", CPU_Cores(), (int)MyGuiChannelWindow::CELLS));
+        BenchMode(win, true, 3);
+        BenchMode(win, false, 3);
+        RLOG(Format("Channel: %d posted, %d coalesced, max drain %d us",
+                    win.channel.GetPosted(), win.channel.GetCoalesced(), win.channel.GetMaxDrainUs()));
+        return;
+    }
+
+    MyGuiChannelWindow().Run();
+}
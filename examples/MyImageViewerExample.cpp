@@ -0,0 +1,193 @@
+#include <CtrlLib/CtrlLib.h>
+#include <plugin/jpg/jpg.h>
+#include <plugin/png/png.h>
+
+using namespace Upp;
+
+// Image viewer that never decodes on the GUI thread (compare with the "Image Viewer"
+// example in UppApplicationSessionGuide.md).
+//
+// The guide's ImageView::Load calls StreamRaster::LoadFileAny and Rescale directly, so a
+// large JPEG freezes the window while it decodes. Here Show only looks into a cache of
+// already scaled images. On a miss it schedules the decode and rescale on a CoWork
+// worker, which posts the finished Image back to the GUI thread; the image is shown if it
+// is still the one the user wants. After every request the neighbouring files in the
+// FileList are prefetched the same way, so stepping through a directory usually finds the
+// next image already decoded.
+//
+// Scaled images are kept in a byte-bounded LRU cache keyed by path and target size, so
+// going back to an already seen image is instant. Requests that were overtaken by several
+// newer ones are skipped by the worker before decoding.
+
+// Byte-bounded LRU of scaled images, GUI thread only
+class ScaledImageCache {
+    struct Entry : Moveable<Entry> {
+        Image image;
+        int64 stamp;
+    };
+
+    VectorMap<String, Entry> map;
+    int64                    bytes = 0;
+    int64                    max_bytes;
+    int64                    clock = 0;
+
+    static int64 SizeOf(const Image& m) { return (int64)m.GetLength() * sizeof(RGBA); }
+
+public:
+    Image Get(const String& key) {
+        int q = map.Find(key);
+        if(q < 0)
+            return Null;
+        map[q].stamp = ++clock;
+        return map[q].image;
+    }
+
+    void Put(const String& key, const Image& m) {
+        int q = map.Find(key);
+        if(q >= 0) {
+            bytes -= SizeOf(map[q].image);
+            map.Remove(q);
+        }
+        while(map.GetCount() && bytes + SizeOf(m) > max_bytes) {
+            int lru = 0;
+            for(int i = 1; i < map.GetCount(); i++)
+                if(map[i].stamp < map[lru].stamp)
+                    lru = i;
+            bytes -= SizeOf(map[lru].image);
+            map.Remove(lru);
+        }
+        Entry& e = map.Add(key);
+        e.image = m;
+        e.stamp = ++clock;
+        bytes += SizeOf(m);
+    }
+
+    int64 GetBytes() const { return bytes; }
+    int   GetCount() const { return map.GetCount(); }
+
+    ScaledImageCache(int64 max_bytes = 256 * 1024 * 1024) : max_bytes(max_bytes) {}
+};
+
+class ImageView : public TopWindow {
+    ImageCtrl        img;
+    FileList         files;
+    Splitter         splitter;
+    String           dir;
+    FrameTop<Button> dirUp;
+    StatusBar        status;
+
+    CoWork           decoder;
+    ScaledImageCache cache;
+    Index<String>    inflight;       // keys being decoded
+    String           current;        // key of the image the user wants to see
+    Atomic           serial;         // incremented with every Show
+
+    static String CacheKey(const String& path, Size sz) { return Format("%s|%d|%d", path, sz.cx, sz.cy); }
+
+    // Worker side: load and scale to fit 'view'
+    static Image DecodeScaled(const String& path, Size view) {
+        Image m = StreamRaster::LoadFileAny(path);
+        if(IsNull(m))
+            return m;
+        Size isz = m.GetSize();
+        if(isz.cx > view.cx || isz.cy > view.cy)
+            m = Rescale(m, GetFitSize(isz, view));
+        return m;
+    }
+
+    void Request(const String& path, Size view) {
+        String key = CacheKey(path, view);
+        if(inflight.Find(key) >= 0 || !IsNull(cache.Get(key)))
+            return;
+        inflight.Add(key);
+        int ticket = serial;
+        decoder & [=] {
+            bool stale = serial - ticket > 4; // the user has moved on
+            Image m = stale ? Image() : DecodeScaled(path, view);
+            if(!CoWork::IsCanceled())
+                PostCallback([=] { Decoded(path, key, m, stale); });
+        };
+    }
+
+    // 'path' comes along with its key: a path may contain '|' itself
+    void Decoded(const String& path, const String& key, const Image& m, bool stale) {
+        inflight.RemoveKey(key);
+        if(stale) {
+            if(key == current) // came back to it in the meantime
+                Request(path, img.GetSize());
+            return;
+        }
+        if(IsNull(m)) {
+            if(key == current)
+                status.Set("Cannot load " + path);
+            return;
+        }
+        cache.Put(key, m);
+        if(key == current)
+            SetImage(m);
+    }
+
+    void SetImage(const Image& m) {
+        img.SetImage(m);
+        status.Set(Format("%d x %d, cache %d images / %d MB", m.GetWidth(), m.GetHeight(),
+                          cache.GetCount(), int(cache.GetBytes() >> 20)));
+    }
+
+    String FilePath(int i) {
+        return i >= 0 && i < files.GetCount() && !files.Get(i).isdir ? AppendFileName(dir, files.Get(i).name)
+                                                                      : String();
+    }
+
+    void Show(int i) {
+        String path = FilePath(i);
+        if(path.IsEmpty())
+            return;
+        serial++;
+        Size view = img.GetSize();
+        current = CacheKey(path, view);
+        Image m = cache.Get(current);
+        if(IsNull(m)) {
+            status.Set("Loading " + GetFileName(path) + "...");
+            Request(path, view);
+        }
+        else
+            SetImage(m);
+        for(int d : { 1, -1, 2 }) // prefetch, most likely next first
+            if(FilePath(i + d).GetCount())
+                Request(FilePath(i + d), view);
+    }
+
+    void LoadDir(const String& d) {
+        dir = d; files.Clear(); Title(dir);
+        ::Load(files, dir, "*.*"); SortByExt(files);
+    }
+
+    void DoDir()       { if(files.IsCursor() && files.Get(files.GetCursor()).isdir)
+                           LoadDir(AppendFileName(dir, files.GetKey())); }
+    void Enter()       { if(files.IsCursor()) Show(files.GetCursor()); }
+    void DirUpClick()  { LoadDir(DirectoryUp(dir)); }
+
+public:
+    typedef ImageView CLASSNAME;
+    ImageView() {
+        Title("Image viewer"); Sizeable().Zoomable();
+        SetRect(0, 0, 1000, 700);
+        splitter.Horz(files, img).SetPos(2600);
+        Add(splitter.SizePos());
+        AddFrame(status);
+        files.WhenEnterItem  = THISBACK(Enter);
+        files.WhenLeftDouble = THISBACK(DoDir);
+        dirUp.SetImage(CtrlImg::DirUp()).NormalStyle();
+        dirUp <<= THISBACK(DirUpClick);
+        files.AddFrame(dirUp);
+        serial = 0;
+        LoadDir(GetCurrentDirectory());
+    }
+    ~ImageView() {
+        decoder.Cancel();
+        decoder.Finish();
+    }
+    virtual bool Key(dword k, int) override { return k==K_ENTER && (DoDir(), true); }
+};
+
+GUI_APP_MAIN { ImageView().Run(); }
@@ -0,0 +1,165 @@
+#include <Core/Core.h>
+
+using namespace Upp;
+
+// Custom Value types stored inline, without heap allocation (compare with
+// MyColorValueExample.cpp).
+//
+// RawToValue(MyColorValue) allocates a reference counted holder for every Value, and
+// every copy of the Value touches the shared counter. Value also has small value
+// optimisation (SVO): types registered with Value::SvoRegister that fit in 8 bytes are
+// stored directly inside the Value, the way int, double, Color or Point are. Creating,
+// copying and destroying them is then a plain 16 byte copy.
+//
+// MyColorValue itself does not fit (Color plus String is 4 + 16 bytes), so MyColorRef
+// below keeps the Color and an id into a table of interned names. Grids usually repeat a
+// small set of names, so the table stays small while the cells no longer allocate.
+//
+// RegisterInlineValueType checks the size at compile time and registers the type.
+// The type number has to be below 255 for SVO and must not collide with the U++ types.
+
+// MyColorValueExample.cpp's type, kept for comparison
+struct MyColorValue {
+    Color  colorVal;
+    String name;
+
+    MyColorValue() : colorVal(Black()) {}
+    MyColorValue(Color c, String n) : colorVal(c), name(n) {}
+
+    String ToString() const { return Sprintf("%s (%s)", name, colorVal.ToString()); }
+};
+
+// Thread-safe table of interned names; ids are never reused
+class NameTable {
+    Mutex         lock;
+    Index<String> names;
+
+public:
+    int Intern(const String& name) {
+        Mutex::Lock __(lock);
+        return names.FindAdd(name);
+    }
+
+    String Get(int id) {
+        Mutex::Lock __(lock);
+        return id >= 0 && id < names.GetCount() ? names[id] : String();
+    }
+
+    int GetCount() {
+        Mutex::Lock __(lock);
+        return names.GetCount();
+    }
+};
+
+inline NameTable& ColorNames() { return Single<NameTable>(); }
+
+enum { MYCOLORREF_V = 200 };
+
+struct MyColorRef : ValueType<MyColorRef, MYCOLORREF_V, Moveable<MyColorRef>> {
+    Color colorVal;
+    int   nameId;
+
+    String GetName() const                      { return ColorNames().Get(nameId); }
+
+    bool     IsNullInstance() const             { return nameId < 0; }
+    hash_t   GetHashValue() const               { return CombineHash(colorVal, nameId); }
+    bool     operator==(const MyColorRef& b) const { return colorVal == b.colorVal && nameId == b.nameId; }
+    bool     operator!=(const MyColorRef& b) const { return !(*this == b); }
+    int      Compare(const MyColorRef& b) const { return SgnCompare(GetName(), b.GetName()); }
+    String   ToString() const                   { return Sprintf("%s (%s)", GetName(), colorVal.ToString()); }
+
+    // Names are stored as text, the ids are only valid within one process
+    void Serialize(Stream& s) {
+        String name = GetName();
+        s % colorVal % name;
+        if(s.IsLoading())
+            nameId = ColorNames().Intern(name);
+    }
+
+    operator Value() const                      { return SvoToValue(*this); }
+
+    MyColorRef(Color c, const String& name)     : colorVal(c), nameId(ColorNames().Intern(name)) {}
+    MyColorRef(const MyColorValue& v)           : MyColorRef(v.colorVal, v.name) {}
+    MyColorRef(const Value& q)                  { *this = q.Get<MyColorRef>(); }
+    MyColorRef(const Nuller&)                   : colorVal(Null), nameId(-1) {}
+    MyColorRef()                                : colorVal(Null), nameId(-1) {}
+};
+
+// Registers T to be stored inside Value, checking what SVO requires
+template <class T>
+void RegisterInlineValueType(const char *name)
+{
+    static_assert(sizeof(T) <= 8, "inline Value types have to fit in 8 bytes");
+    ASSERT(T::ValueTypeNo() < 255); // SVO slots are indexed by type number
+    Value::SvoRegister<T>(name);
+}
+
+INITBLOCK {
+    RegisterInlineValueType<MyColorRef>("MyColorRef");
+}
+
+// Runs fn 'n' times and returns the rate in millions per second
+template <class Fn>
+static double Mops(int n, const Fn& fn)
+{
+    int64 t0 = usecs();
+    for(int i = 0; i < n; i++)
+        fn(i);
+    return n / (double)max<int64>(usecs(t0), 1);
+}
+
+CONSOLE_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    MyColorRef red(Red(), "Red");
+    Value v = red;
+    ASSERT(v.Is<MyColorRef>() && v.Get<MyColorRef>() == red);
+    MyColorRef loaded;
+    ASSERT(LoadFromString(loaded, StoreAsString(red)) && loaded == red);
+    DUMP(v);
+
+    const char *names[] = { "Primary", "Secondary", "Warning", "Error", "Disabled", "Accent" };
+    MyColorValue raw(Magenta(), names[0]);
+    MyColorRef inl(raw);
+
+    int n = 10000000;
+    int64 check = 0;
+
+    double raw_make = Mops(n, [&](int i) { Value q = RawToValue(raw); check += q.Is<MyColorValue>(); });
+    double inl_make = Mops(n, [&](int i) { Value q = inl; check += q.Is<MyColorRef>(); });
+
+    Value rv = RawToValue(raw), iv = inl;
+    double raw_copy = Mops(n, [&](int i) { Value q = rv; check += q.IsVoid(); });
+    double inl_copy = Mops(n, [&](int i) { Value q = iv; check += q.IsVoid(); });
+
+    double raw_is = Mops(n, [&](int i) { check += rv.Is<MyColorValue>(); });
+    double inl_is = Mops(n, [&](int i) { check += iv.Is<MyColorRef>(); });
+
+    double raw_get = Mops(n, [&](int i) { check += rv.Get<MyColorValue>().colorVal.GetR(); });
+    double inl_get = Mops(n, [&](int i) { check += iv.Get<MyColorRef>().colorVal.GetR(); });
+
+    RLOG(Format("%-10s %12s %12s", "M ops/s", "RawToValue", "inline"));
+    RLOG(Format("%-10s %12.1f %12.1f", "construct", raw_make, inl_make));
+    RLOG(Format("%-10s %12.1f %12.1f", "copy", raw_copy, inl_copy));
+    RLOG(Format("%-10s %12.1f %12.1f", "Is<T>()", raw_is, inl_is));
+    RLOG(Format("%-10s %12.1f %12.1f", "Get<T>()", raw_get, inl_get));
+
+    // Memory of a grid column with a million distinct cells
+    int cells = 1000000;
+    int mem0 = MemoryUsedKb();
+    {
+        ValueArray va;
+        for(int i = 0; i < cells; i++)
+            va.Add(RawToValue(MyColorValue(Color(i & 255, 0, 0), names[i % 6])));
+        RLOG("ValueArray of RawToValue cells: " << MemoryUsedKb() - mem0 << " KB");
+    }
+    mem0 = MemoryUsedKb();
+    {
+        ValueArray va;
+        for(int i = 0; i < cells; i++)
+            va.Add(MyColorRef(Color(i & 255, 0, 0), names[i % 6]));
+        RLOG("ValueArray of inline cells:     " << MemoryUsedKb() - mem0 << " KB, "
+             << ColorNames().GetCount() << " interned names");
+    }
+    RLOG("(check " << check << ")");
+}
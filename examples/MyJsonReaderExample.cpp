@@ -0,0 +1,711 @@
+#include <Core/Core.h>
+
+#ifdef CPU_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace Upp;
+
+// Streaming JSON: a pull reader and a Jsonize binder without a Value tree (compare with
+// ParseJSON / LoadFromJson from Core/JSON.h in UppApplicationSessionGuide.md).
+//
+// ParseJSON builds the whole document as ValueMap / ValueArray nodes before anything can
+// be read out of it, and LoadFromJson goes through that tree too. JsonPullReader reads
+// from any Stream through a fixed window and returns one token per Next(): begin/end of
+// object or array, key, string, number, true, false, null. Memory use is the window plus
+// the longest token, independent of the document size. Several top-level values in a row
+// (newline-delimited feeds) are accepted.
+//
+// Whitespace and string bodies are scanned 16 bytes at a time with SSE2 (scalar loop on
+// other CPUs): a string is searched for the closing quote, a backslash or a control
+// character in one compare per block, so escape-free strings are not copied at all - the
+// token refers to the window until the next call of Next.
+//
+// Types with a templated Jsonize
+//
+//     template <class IO> void Jsonize(IO& io) { io("name", name)("value", value); }
+//
+// work with both the standard JsonIO and JsonPullIO. JsonPullIO only records
+// where each key's variable is; the object's keys are then read from the stream in any
+// order and loaded straight into the variables, unknown keys are skipped.
+// ForEachJsonElement loads a top-level array element by element into a single T, which is
+// how a large feed is processed in constant memory.
+
+enum {
+    JSON_EOF, JSON_BEGIN_OBJECT, JSON_END_OBJECT, JSON_BEGIN_ARRAY, JSON_END_ARRAY,
+    JSON_KEY, JSON_STRING, JSON_NUMBER, JSON_TRUE, JSON_FALSE, JSON_NULL, JSON_ERROR
+};
+
+class JsonPullReader;
+
+struct JsonPullField : Moveable<JsonPullField> {
+    const char *key;
+    void       *var;
+    void      (*load)(JsonPullReader& r, void *var);
+};
+
+class JsonPullReader : NoCopy {
+    enum { WINDOW = 64 * 1024, PAD = 16 };
+    enum { ST_VALUE, ST_FIRST_VALUE, ST_KEY, ST_FIRST_KEY, ST_COLON, ST_AFTER };
+
+    Stream&      in;
+    Buffer<char> buf;
+    int          cap;              // usable size of buf, PAD zero bytes follow the data
+    int          pos = 0;
+    int          len = 0;
+    int64        base = 0;         // stream offset of buf[0]
+    bool         eof = false;
+
+    Vector<char> ctx;              // '{' / '[' nesting
+    int          state = ST_VALUE;
+    int          token = JSON_EOF;
+    bool         repeat = false;
+    String       error;
+
+    const char  *text = nullptr;   // current string / key / number text
+    int          text_len = 0;
+    Vector<char> unescaped;
+    double       number = 0;
+    int64        inumber = 0;
+    bool         is_int = false;
+
+    Array<Vector<JsonPullField>> fields; // per-depth storage for JsonPullIO
+
+    // Ensures 'need' bytes from pos are in the window unless the stream ends
+    bool Fill(int need) {
+        if(len - pos >= need)
+            return true;
+        if(pos) {
+            memmove(~buf, ~buf + pos, len - pos);
+            base += pos;
+            len -= pos;
+            pos = 0;
+        }
+        while(len < need && !eof) {
+            if(need > cap) {
+                int ncap = max(need, 2 * cap);
+                Buffer<char> nb(ncap + PAD);
+                memcpy(~nb, ~buf, len);
+                buf = pick(nb);
+                cap = ncap;
+            }
+            int n = in.Get(~buf + len, cap - len);
+            if(n <= 0)
+                eof = true;
+            else
+                len += n;
+        }
+        memset(~buf + len, 0, PAD);
+        return len >= need;
+    }
+
+    // Number of leading blanks in s[0..16)
+    static int Blanks16(const char *s) {
+#ifdef CPU_SSE2
+        __m128i v = _mm_loadu_si128((const __m128i *)s);
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                               _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\r')),
+                                               _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))));
+        dword m = ~_mm_movemask_epi8(ws) & 0xffff;
+        return m ? CountTrailingZeroBits(m) : 16;
+#else
+        int i = 0;
+        while(i < 16 && (s[i] == ' ' || s[i] == '\n' || s[i] == '\r' || s[i] == '\t'))
+            i++;
+        return i;
+#endif
+    }
+
+    // Position of the first '"', '\\' or control character in s[0..16), 16 if none
+    static int Special16(const char *s) {
+#ifdef CPU_SSE2
+        __m128i v = _mm_loadu_si128((const __m128i *)s);
+        __m128i ctrl = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1f)), _mm_set1_epi8(0x1f));
+        __m128i sp = _mm_or_si128(ctrl, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\"')),
+                                                     _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+        dword m = _mm_movemask_epi8(sp);
+        return m ? CountTrailingZeroBits(m) : 16;
+#else
+        int i = 0;
+        while(i < 16 && s[i] != '\"' && s[i] != '\\' && (byte)s[i] >= 0x20)
+            i++;
+        return i;
+#endif
+    }
+
+    // Skips blanks, false at the end of the stream
+    bool SkipBlanks() {
+        for(;;) {
+            if(pos >= len && !Fill(1))
+                return false;
+            pos += Blanks16(~buf + pos); // the zero padding stops the scan at len
+            if(pos < len)
+                return true;
+        }
+    }
+
+    int Fail(const char *msg) {
+        if(error.IsEmpty())
+            error = Format("%s at offset %d", msg, GetPos());
+        return token = JSON_ERROR;
+    }
+
+    static int Hex4(const char *s) {
+        int h = 0;
+        for(int i = 0; i < 4; i++) {
+            int c = s[i];
+            int d = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                  : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if(d < 0)
+                return -1;
+            h = 16 * h + d;
+        }
+        return h;
+    }
+
+    void Unescaped(const char *s, int n) {
+        int q = unescaped.GetCount();
+        unescaped.SetCount(q + n);
+        memcpy(unescaped.begin() + q, s, n);
+    }
+
+    void PutUtf8(int c) {
+        if(c < 0x80)
+            unescaped.Add((char)c);
+        else
+        if(c < 0x800) {
+            unescaped.Add(char(0xc0 | (c >> 6)));
+            unescaped.Add(char(0x80 | (c & 0x3f)));
+        }
+        else
+        if(c < 0x10000) {
+            unescaped.Add(char(0xe0 | (c >> 12)));
+            unescaped.Add(char(0x80 | ((c >> 6) & 0x3f)));
+            unescaped.Add(char(0x80 | (c & 0x3f)));
+        }
+        else {
+            unescaped.Add(char(0xf0 | (c >> 18)));
+            unescaped.Add(char(0x80 | ((c >> 12) & 0x3f)));
+            unescaped.Add(char(0x80 | ((c >> 6) & 0x3f)));
+            unescaped.Add(char(0x80 | (c & 0x3f)));
+        }
+    }
+
+    // pos is at the opening quote; sets text, moves pos past the closing quote
+    bool ReadString() {
+        int i = 1;   // relative to pos, the window may move while scanning
+        int run = 1; // start of the not yet copied part when unescaping
+        bool escaped = false;
+        unescaped.SetCount(0);
+        for(;;) {
+            if(pos + i + PAD > len && !eof) {
+                Fill(i + PAD + 1);
+                continue;
+            }
+            i += Special16(~buf + pos + i);
+            if(pos + i >= len)
+                return !Fail("Unterminated string");
+            char c = buf[pos + i];
+            if(c == '\"')
+                break;
+            if(c != '\\')
+                return !Fail("Control character in string");
+            Fill(i + 12); // the longest escape is a \uXXXX\uXXXX surrogate pair
+            if(pos + i + 1 >= len)
+                return !Fail("Unterminated escape");
+            escaped = true;
+            Unescaped(~buf + pos + run, i - run);
+            char e = buf[pos + i + 1];
+            i += 2;
+            switch(e) {
+            case '\"': unescaped.Add('\"'); break;
+            case '\\': unescaped.Add('\\'); break;
+            case '/':  unescaped.Add('/'); break;
+            case 'b':  unescaped.Add('\b'); break;
+            case 'f':  unescaped.Add('\f'); break;
+            case 'n':  unescaped.Add('\n'); break;
+            case 'r':  unescaped.Add('\r'); break;
+            case 't':  unescaped.Add('\t'); break;
+            case 'u': {
+                int c = Hex4(~buf + pos + i);
+                if(c < 0)
+                    return !Fail("Invalid \\u escape");
+                i += 4;
+                if(c >= 0xd800 && c < 0xdc00 && buf[pos + i] == '\\' && buf[pos + i + 1] == 'u') {
+                    int lo = Hex4(~buf + pos + i + 2);
+                    if(lo >= 0xdc00 && lo < 0xe000) {
+                        c = 0x10000 + ((c - 0xd800) << 10) + (lo - 0xdc00);
+                        i += 6;
+                    }
+                }
+                PutUtf8(c);
+                break;
+            }
+            default:
+                return !Fail("Invalid escape");
+            }
+            run = i;
+        }
+        if(escaped) {
+            Unescaped(~buf + pos + run, i - run);
+            text = unescaped.begin();
+            text_len = unescaped.GetCount();
+        }
+        else {
+            text = ~buf + pos + 1;
+            text_len = i - 1;
+        }
+        pos += i + 1;
+        return true;
+    }
+
+    bool ReadNumber() {
+        int i = 0;
+        for(;;) {
+            if(pos + i >= len) {
+                Fill(i + 64);
+                if(pos + i >= len)
+                    break;
+            }
+            char c = buf[pos + i];
+            if(!(IsDigit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E'))
+                break;
+            i++;
+        }
+        text = ~buf + pos;
+        text_len = i;
+        pos += i;
+        const char *s = text, *e = text + text_len;
+        bool neg = s < e && *s == '-';
+        s += neg;
+        if(s == e || !IsDigit(*s))
+            return !Fail("Invalid number");
+        // JSON grammar: int [frac] [exp], no leading zeros; this also rejects "1-2"
+        const char *q = s;
+        if(*q == '0')
+            q++;
+        else
+            while(q < e && IsDigit(*q))
+                q++;
+        if(q < e && *q == '.') {
+            if(++q == e || !IsDigit(*q))
+                return !Fail("Invalid number");
+            while(q < e && IsDigit(*q))
+                q++;
+        }
+        if(q < e && (*q == 'e' || *q == 'E')) {
+            q++;
+            if(q < e && (*q == '+' || *q == '-'))
+                q++;
+            if(q == e || !IsDigit(*q))
+                return !Fail("Invalid number");
+            while(q < e && IsDigit(*q))
+                q++;
+        }
+        if(q != e)
+            return !Fail("Invalid number");
+        int64 n = 0;
+        const char *d = s;
+        while(d < e && IsDigit(*d) && d - s < 18)
+            n = 10 * n + (*d++ - '0');
+        if(d == e) {
+            is_int = true;
+            inumber = neg ? -n : n;
+            number = (double)inumber;
+            return true;
+        }
+        char tmp[80];
+        if(text_len >= (int)sizeof(tmp))
+            return !Fail("Number too long");
+        memcpy(tmp, text, text_len);
+        tmp[text_len] = 0;
+        number = ScanDouble(tmp);
+        if(IsNull(number))
+            return !Fail("Invalid number");
+        is_int = false;
+        // 1e300 or a 19+ digit integer does not fit: saturate instead of an undefined cast
+        if(number >= 9223372036854775808.0)
+            inumber = INT64_MAX;
+        else
+        if(number < -9223372036854775808.0)
+            inumber = INT64_MIN;
+        else
+            inumber = (int64)number;
+        return true;
+    }
+
+    int ReadValue() {
+        char c = buf[pos];
+        if(c == '{') {
+            pos++;
+            ctx.Add('{');
+            state = ST_FIRST_KEY;
+            return token = JSON_BEGIN_OBJECT;
+        }
+        if(c == '[') {
+            pos++;
+            ctx.Add('[');
+            state = ST_FIRST_VALUE;
+            return token = JSON_BEGIN_ARRAY;
+        }
+        state = ST_AFTER;
+        if(c == '\"')
+            return ReadString() ? token = JSON_STRING : JSON_ERROR;
+        if(c == '-' || IsDigit(c))
+            return ReadNumber() ? token = JSON_NUMBER : JSON_ERROR;
+        Fill(5);
+        if(memcmp(~buf + pos, "true", 4) == 0)  { pos += 4; return token = JSON_TRUE; }
+        if(memcmp(~buf + pos, "false", 5) == 0) { pos += 5; return token = JSON_FALSE; }
+        if(memcmp(~buf + pos, "null", 4) == 0)  { pos += 4; return token = JSON_NULL; }
+        return Fail("Unexpected character");
+    }
+
+    int Close(char c) {
+        if(ctx.IsEmpty() || ctx.Top() != (c == '}' ? '{' : '['))
+            return Fail("Unbalanced bracket");
+        ctx.Drop();
+        pos++;
+        state = ST_AFTER;
+        return token = c == '}' ? JSON_END_OBJECT : JSON_END_ARRAY;
+    }
+
+public:
+    int Next() {
+        if(repeat) {
+            repeat = false;
+            return token;
+        }
+        if(token == JSON_ERROR)
+            return JSON_ERROR;
+        for(;;) {
+            if(!SkipBlanks()) {
+                if(ctx.GetCount() || state == ST_COLON || (state == ST_VALUE && token == JSON_KEY))
+                    return Fail("Unexpected end of input");
+                return token = JSON_EOF;
+            }
+            char c = buf[pos];
+            switch(state) {
+            case ST_AFTER:
+                if(ctx.IsEmpty()) { // another top-level value
+                    state = ST_VALUE;
+                    continue;
+                }
+                if(c == ',') {
+                    pos++;
+                    state = ctx.Top() == '{' ? ST_KEY : ST_VALUE;
+                    continue;
+                }
+                if(c == '}' || c == ']')
+                    return Close(c);
+                return Fail("Expected ',' or closing bracket");
+            case ST_FIRST_VALUE:
+                if(c == ']')
+                    return Close(c);
+                return ReadValue();
+            case ST_VALUE:
+                return ReadValue();
+            case ST_FIRST_KEY:
+            case ST_KEY:
+                if(c == '}' && state == ST_FIRST_KEY)
+                    return Close(c);
+                if(c != '\"')
+                    return Fail("Expected key");
+                if(!ReadString())
+                    return JSON_ERROR;
+                state = ST_COLON; // ':' is read by the next call, the key text must stay valid
+                return token = JSON_KEY;
+            case ST_COLON:
+                if(c != ':')
+                    return Fail("Expected ':'");
+                pos++;
+                state = ST_VALUE;
+                continue;
+            }
+        }
+    }
+
+    // Next() returns the current token once more
+    void Back()                          { repeat = true; }
+
+    // Skips the value whose first token was just returned by Next
+    void SkipValue() {
+        if(token != JSON_BEGIN_OBJECT && token != JSON_BEGIN_ARRAY)
+            return;
+        int depth = ctx.GetCount();
+        while(ctx.GetCount() >= depth && Next() != JSON_ERROR && token != JSON_EOF)
+            ;
+    }
+
+    // Text of the current key / string / number, valid until the next call of Next
+    const char *GetText() const          { return text; }
+    int         GetTextLength() const    { return text_len; }
+    String      GetString() const        { return String(text, text_len); }
+    bool        IsText(const char *s) const { return strlen(s) == (size_t)text_len && memcmp(s, text, text_len) == 0; }
+
+    double      GetNumber() const        { return number; }
+    int64       GetInt64() const         { return inumber; } // saturated when out of range
+    bool        IsInt() const            { return is_int; }
+
+    int         GetToken() const         { return token; }
+    int         GetDepth() const         { return ctx.GetCount(); }
+    int64       GetPos() const           { return base + pos; }
+    bool        IsError() const          { return token == JSON_ERROR; }
+    const String& GetError() const       { return error; }
+    void        SetError(const char *msg) { Fail(msg); }
+
+    Vector<JsonPullField>& Fields()      { int d = ctx.GetCount(); while(fields.GetCount() <= d) fields.Add(); return fields[d]; }
+
+    JsonPullReader(Stream& in) : in(in), buf(WINDOW + PAD), cap(WINDOW) { memset(~buf, 0, PAD); }
+};
+
+inline void JsonPullNumber(JsonPullReader& r, double& x, int64& n)
+{
+    int t = r.Next();
+    if(t == JSON_NUMBER) {
+        x = r.GetNumber();
+        n = r.GetInt64();
+    }
+    else
+    if(t != JSON_NULL) {
+        r.SkipValue();
+        r.SetError("Number expected");
+    }
+}
+
+inline void JsonPullLoad(JsonPullReader& r, int& x)    { double d = x; int64 n = x; JsonPullNumber(r, d, n); x = (int)n; }
+inline void JsonPullLoad(JsonPullReader& r, int64& x)  { double d = (double)x; JsonPullNumber(r, d, x); }
+inline void JsonPullLoad(JsonPullReader& r, double& x) { int64 n = 0; JsonPullNumber(r, x, n); }
+
+inline void JsonPullLoad(JsonPullReader& r, bool& x)
+{
+    int t = r.Next();
+    if(t == JSON_TRUE || t == JSON_FALSE)
+        x = t == JSON_TRUE;
+    else
+    if(t != JSON_NULL) {
+        r.SkipValue();
+        r.SetError("Boolean expected");
+    }
+}
+
+inline void JsonPullLoad(JsonPullReader& r, String& x)
+{
+    int t = r.Next();
+    if(t == JSON_STRING)
+        x = r.GetString();
+    else
+    if(t == JSON_NULL)
+        x = Null;
+    else {
+        r.SkipValue();
+        r.SetError("String expected");
+    }
+}
+
+template <class T>
+void JsonPullLoad(JsonPullReader& r, Vector<T>& x)
+{
+    x.Clear();
+    int t = r.Next();
+    if(t == JSON_NULL)
+        return;
+    if(t != JSON_BEGIN_ARRAY) {
+        r.SkipValue();
+        r.SetError("Array expected");
+        return;
+    }
+    for(;;) {
+        t = r.Next();
+        if(t == JSON_END_ARRAY || t == JSON_ERROR || t == JSON_EOF)
+            break;
+        r.Back();
+        JsonPullLoad(r, x.Add());
+    }
+}
+
+// Binds the keys of one object to variables, like JsonIO when loading
+class JsonPullIO {
+    Vector<JsonPullField>& field;
+
+public:
+    template <class T>
+    JsonPullIO& operator()(const char *key, T& var) {
+        JsonPullField& f = field.Add();
+        f.key = key;
+        f.var = &var;
+        f.load = [](JsonPullReader& r, void *p) { JsonPullLoad(r, *(T *)p); };
+        return *this;
+    }
+
+    template <class T>
+    JsonPullIO& operator()(const char *key, T& var, const T& def) {
+        var = def;
+        return (*this)(key, var);
+    }
+
+    bool IsLoading() const { return true; }
+    bool IsStoring() const { return false; }
+
+    JsonPullIO(Vector<JsonPullField>& field) : field(field) {}
+};
+
+// Any type with a templated Jsonize
+template <class T>
+void JsonPullLoad(JsonPullReader& r, T& x)
+{
+    int t = r.Next();
+    if(t == JSON_NULL)
+        return;
+    if(t != JSON_BEGIN_OBJECT) {
+        r.SkipValue();
+        r.SetError("Object expected");
+        return;
+    }
+    Vector<JsonPullField>& field = r.Fields();
+    int first = field.GetCount();
+    JsonPullIO io(field);
+    x.Jsonize(io);
+    int last = field.GetCount();
+    while(r.Next() == JSON_KEY) {
+        int i = first;
+        while(i < last && !r.IsText(field[i].key))
+            i++;
+        if(i < last)
+            field[i].load(r, field[i].var);
+        else {
+            r.Next();
+            r.SkipValue();
+        }
+    }
+    field.SetCount(first);
+    if(r.GetToken() != JSON_END_OBJECT)
+        r.SetError("Unterminated object");
+}
+
+template <class T>
+bool LoadFromJsonStream(T& x, Stream& in)
+{
+    JsonPullReader r(in);
+    JsonPullLoad(r, x);
+    return !r.IsError() && r.Next() == JSON_EOF;
+}
+
+// Calls fn(const T&) for every element of a top-level array, one element in memory at a time
+template <class T, class F>
+bool ForEachJsonElement(Stream& in, F fn)
+{
+    JsonPullReader r(in);
+    if(r.Next() != JSON_BEGIN_ARRAY)
+        return false;
+    for(;;) {
+        int t = r.Next();
+        if(t == JSON_END_ARRAY)
+            return r.Next() == JSON_EOF;
+        if(t == JSON_ERROR || t == JSON_EOF)
+            return false;
+        r.Back();
+        T x;
+        JsonPullLoad(r, x);
+        if(r.IsError())
+            return false;
+        fn(x);
+    }
+}
+
+// MySerializableObject from MySerializationExample.cpp, with a list of tags
+struct MySerializableObject : Moveable<MySerializableObject> {
+    String         name;
+    int            value = 0;
+    Vector<String> tags;
+
+    template <class IO>
+    void Jsonize(IO& io) {
+        io("name", name)("value", value)("tags", tags);
+    }
+};
+
+CONSOLE_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    {
+        StringStream ss("{\"value\": -12, \"extra\": {\"a\": [1, 2.5e3, null]}, "
+                        "\"name\": \"caf\\u00e9 \\\"quoted\\\"\", \"tags\": [\"x\", \"y\"]}");
+        MySerializableObject o;
+        bool ok = LoadFromJsonStream(o, ss);
+        ASSERT(ok && o.value == -12 && o.name == "caf\xc3\xa9 \"quoted\"" && o.tags.GetCount() == 2);
+        RLOG("Small document: " << (ok ? "ok" : "failed") << ", name " << o.name << ", value " << o.value);
+    }
+
+    int count = 1000000;
+    for(const String& a : CommandLine())
+        if(a.StartsWith("--count="))
+            count = max(1, ScanInt(a.Mid(8)));
+
+    String path = GetTempFileName();
+    {
+        FileOut out(path);
+        out << "[\n";
+        for(int i = 0; i < count; i++)
+            out << (i ? ",\n" : "")
+                << "{\"name\": \"Object number " << i << "\", \"value\": " << i
+                << ", \"tags\": [\"event\", \"t" << i % 10 << "\"]"
+                << ", \"meta\": {\"source\": \"feed \\\"main\\\"\", \"weight\": " << i * 0.25 << "}}";
+        out << "\n]\n";
+    }
+    double mb = GetFileLength(path) / (1024.0 * 1024.0);
+    RLOG(Format("%d objects, %.1f MB of JSON", count, mb));
+
+    auto report = [&](const char *name, int64 t, int mem, int64 check) {
+        RLOG(Format("  %-34s %8.1f ms %7.0f MB/s %9d KB heap (check %d)",
+                    name, t / 1000.0, mb / max(t / 1e6, 1e-9), mem, check));
+    };
+
+    {
+        int mem0 = MemoryUsedKb();
+        int64 t0 = usecs();
+        Value v = ParseJSON(LoadFile(path));
+        int64 t = usecs(t0);
+        report("ParseJSON (Value tree)", t, MemoryUsedKb() - mem0, v.GetCount());
+    }
+    {
+        int mem0 = MemoryUsedKb();
+        int64 t0 = usecs();
+        Vector<MySerializableObject> data;
+        LoadFromJson(data, LoadFile(path));
+        int64 t = usecs(t0);
+        report("LoadFromJson (JsonIO)", t, MemoryUsedKb() - mem0, data.GetCount() ? data.Top().value : -1);
+    }
+    {
+        int64 t0 = usecs();
+        FileIn in(path);
+        JsonPullReader r(in);
+        int64 tokens = 0;
+        for(int t; (t = r.Next()) != JSON_EOF && t != JSON_ERROR;)
+            tokens++;
+        report("JsonPullReader tokens", usecs(t0), 0, tokens);
+    }
+    {
+        int mem0 = MemoryUsedKb();
+        int64 t0 = usecs();
+        FileIn in(path);
+        Vector<MySerializableObject> data;
+        LoadFromJsonStream(data, in);
+        int64 t = usecs(t0);
+        report("LoadFromJsonStream (JsonPullIO)", t, MemoryUsedKb() - mem0, data.GetCount() ? data.Top().value : -1);
+    }
+    {
+        int mem0 = MemoryUsedKb();
+        int peak = 0;
+        int64 t0 = usecs();
+        FileIn in(path);
+        int64 sum = 0;
+        ForEachJsonElement<MySerializableObject>(in, [&](const MySerializableObject& o) {
+            sum += o.value;
+            if((o.value & 0xffff) == 0)
+                peak = max(peak, MemoryUsedKb() - mem0);
+        });
+        report("ForEachJsonElement", usecs(t0), peak, sum);
+    }
+    DeleteFile(path);
+}
@@ -0,0 +1,372 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Large generated dialogs with lazily created tab pages and cached layouts (compare
+// with WithMyDialogLayout in MyDialogTemplateExample.cpp).
+//
+// WithMyDialogLayout creates and positions every control in its constructor. A generated
+// configuration dialog with thousands of items pays for all of them when it opens, even
+// for tabs that are never looked at. Here:
+//
+//  - a page is described by a PageSpec, the list of LayoutItems of a layout (control
+//    kind, label and the LeftPos / RightPos / HSizePos / TopPos / BottomPos / VSizePos
+//    style alignment) and its design size
+//  - PageSpecs come straight from .lay files: with the LAYOUT / ITEM / END_LAYOUT macros
+//    defined as below, including MyLazyDialogPages.lay generates one <name>Spec function
+//    per layout. Each ITEM keeps the factory of its class and its .lay parameters; the
+//    positions are read by applying the parameters once to a probe control per class.
+//    The same file still works with CtrlLayout and <CtrlCore/lay.h>
+//  - each tab holds an empty LazyPage; its controls are only created the first time the
+//    tab is shown. The controls live in a view as tall as the layout needs, which the
+//    page scrolls, so tall generated pages stay reachable
+//  - positions are computed from the spec by ComputeLayout, a pure function of the spec
+//    and the view size, and kept in a small per-page LayoutCache keyed by size. When the
+//    first page finds out the actual page size, the layouts of all other pages are
+//    computed for it on CoWork, so visiting a tab later only creates controls and copies
+//    rectangles. Nothing is laid out or precomputed while a page has no size yet.
+//    Controls themselves are only ever touched on the GUI thread.
+//
+// Run with "--bench" to compare opening the eager and the lazy dialog, the first visit
+// of a tab and relayout with a cache hit and a miss.
+
+enum { LAY_LABEL, LAY_EDIT, LAY_OPTION, LAY_DROPLIST, LAY_INT };
+
+// One horizontal or vertical placement: Ctrl::LEFT (a = offset, b = size),
+// Ctrl::RIGHT (a = offset from the far side, b = size), Ctrl::SIZE (a, b = both insets)
+// or Ctrl::CENTER (a = shift, b = size)
+struct LayoutAxis {
+    int align;
+    int a, b;
+};
+
+struct LayoutItem : Moveable<LayoutItem> {
+    int        kind;
+    String     label;
+    LayoutAxis x, y;
+    Ctrl    *(*create)() = nullptr;       // items from a .lay file: the ITEM class
+    void     (*setup)(Ctrl&) = nullptr;   // and its parameters
+};
+
+static void PlaceAxis(const LayoutAxis& p, int size, int& pos, int& len)
+{
+    switch(p.align) {
+    case Ctrl::RIGHT:  pos = size - p.a - p.b; len = p.b; break;
+    case Ctrl::SIZE:   pos = p.a; len = max(0, size - p.a - p.b); break;
+    case Ctrl::CENTER: pos = (size - p.b) / 2 + p.a; len = p.b; break;
+    default:           pos = p.a; len = p.b; break;
+    }
+}
+
+static Vector<Rect> ComputeLayout(const Vector<LayoutItem>& item, Size sz)
+{
+    Vector<Rect> r;
+    r.SetCount(item.GetCount());
+    for(int i = 0; i < item.GetCount(); i++) {
+        int x, cx, y, cy;
+        PlaceAxis(item[i].x, sz.cx, x, cx);
+        PlaceAxis(item[i].y, sz.cy, y, cy);
+        r[i] = RectC(x, y, cx, cy);
+    }
+    return r;
+}
+
+// Rectangles per page size, shared by the GUI thread and the CoWork precompute jobs
+class LayoutCache : NoCopy {
+    enum { MAXSIZES = 8 };             // a live resize would otherwise fill it
+
+    Mutex                        lock;
+    ArrayMap<Size, Vector<Rect>> rect;
+
+public:
+    bool Get(Size sz, Vector<Rect>& r) {
+        Mutex::Lock __(lock);
+        int q = rect.Find(sz);
+        if(q < 0)
+            return false;
+        r = clone(rect[q]);
+        return true;
+    }
+
+    bool Has(Size sz) {
+        Mutex::Lock __(lock);
+        return rect.Find(sz) >= 0;
+    }
+
+    void Put(Size sz, Vector<Rect>&& r) {
+        Mutex::Lock __(lock);
+        if(rect.Find(sz) >= 0)
+            return;
+        if(rect.GetCount() >= MAXSIZES)
+            rect.Remove(0);
+        rect.Add(sz, pick(r));
+    }
+};
+
+struct PageSpec {
+    String             title;
+    Size               size = Size(0, 0); // design size, the minimal height of the view
+    Vector<LayoutItem> item;
+    LayoutCache        cache;
+};
+
+// Size of the scrolled view of a page of 'page' size
+static Size ContentSize(const PageSpec& spec, Size page)
+{
+    return Size(page.cx, max(page.cy, spec.size.cy));
+}
+
+static LayoutAxis ToLayoutAxis(const Ctrl::Logc& c)
+{
+    return { c.GetAlign(), c.GetA(), c.GetB() };
+}
+
+// One ITEM of a .lay file; 'probe' keeps one control per class to read positions from
+template <class T>
+void AddLayoutItem(PageSpec& spec, ArrayMap<String, Ctrl>& probe, const char *var, void (*setup)(Ctrl&))
+{
+    String key = typeid(T).name();
+    int q = probe.Find(key);
+    Ctrl& c = q >= 0 ? probe[q] : probe.Create<T>(key);
+    c.LeftPos(0, 0).TopPos(0, 0);
+    setup(c);
+    LayoutItem& m = spec.item.Add();
+    m.kind = LAY_LABEL;
+    m.label = var;
+    m.x = ToLayoutAxis(c.GetPos().x);
+    m.y = ToLayoutAxis(c.GetPos().y);
+    m.create = [] () -> Ctrl * { return new T; };
+    m.setup = setup;
+}
+
+#define LAYOUT(nm, cx, cy)       static void nm##Spec(PageSpec& spec) { \
+                                     spec.size = Size(cx, cy); \
+                                     ArrayMap<String, Ctrl> probe;
+#define ITEM(klass, var, param)      AddLayoutItem<klass>(spec, probe, #var, [](Ctrl& c) { static_cast<klass&>(c).param; });
+#define UNTYPED(var, param)
+#define END_LAYOUT               }
+
+#define LAYOUTFILE "MyLazyDialogPages.lay"
+#include LAYOUTFILE
+
+#undef LAYOUT
+#undef ITEM
+#undef UNTYPED
+#undef END_LAYOUT
+#undef LAYOUTFILE
+
+class LazyPage : public ParentCtrl {
+    PageSpec&   spec;
+    ScrollBar   sb;
+    ParentCtrl  view;                 // holds the controls, ContentSize tall
+    Array<Ctrl> ctrl;
+
+    void Scroll()    { view.SetRect(0, -sb.Get(), view.GetSize().cx, view.GetSize().cy); }
+
+public:
+    Event<Size> WhenNewSize;          // a page size with no cached layout was computed here
+
+    int         misses = 0;
+
+    bool IsCreated() const { return ctrl.GetCount() || spec.item.IsEmpty(); }
+
+    void Create() {
+        if(IsCreated())
+            return;
+        ctrl.Reserve(spec.item.GetCount());
+        for(const LayoutItem& m : spec.item) {
+            if(m.create) {
+                Ctrl *c = m.create();
+                m.setup(*c);
+                ctrl.Add(c);
+                view.Add(*c);
+                continue;
+            }
+            switch(m.kind) {
+            case LAY_LABEL:    ctrl.Create<Label>().SetLabel(m.label); break;
+            case LAY_OPTION:   ctrl.Create<Option>().SetLabel(m.label); break;
+            case LAY_DROPLIST: {
+                DropList& d = ctrl.Create<DropList>();
+                d.Add(0, "Off").Add(1, "On").Add(2, "Auto");
+                d <<= 2;
+                break;
+            }
+            case LAY_INT:      ctrl.Create<EditInt>() <<= 0; break;
+            default:           ctrl.Create<EditString>(); break;
+            }
+            view.Add(ctrl.Top());
+        }
+        Layout();
+    }
+
+    virtual void Layout() override {
+        Size sz = GetSize();
+        if(sz.cx <= 0 || sz.cy <= 0)
+            return; // not placed yet, a layout for this size would be of no use
+        Size csz = ContentSize(spec, sz);
+        sb.SetPage(sz.cy);
+        sb.SetTotal(csz.cy);
+        view.SetRect(0, -sb.Get(), csz.cx, csz.cy);
+        if(ctrl.IsEmpty())
+            return;
+        Vector<Rect> r;
+        if(!spec.cache.Get(csz, r)) {
+            r = ComputeLayout(spec.item, csz);
+            spec.cache.Put(csz, clone(r));
+            misses++;
+            WhenNewSize(sz);
+        }
+        for(int i = 0; i < ctrl.GetCount(); i++)
+            ctrl[i].SetRect(r[i]);
+    }
+
+    virtual void MouseWheel(Point, int zdelta, dword) override {
+        sb.Wheel(zdelta);
+    }
+
+    LazyPage(PageSpec& spec) : spec(spec) {
+        AddFrame(sb);
+        sb.SetLine(24);
+        sb.WhenScroll = [=] { Scroll(); };
+        Add(view);
+    }
+};
+
+// Stands in for a generated configuration dialog: two pages from MyLazyDialogPages.lay,
+// then 'pages' tabs of 'rows' label + editor rows
+static void MakeSpecs(Array<PageSpec>& spec, int pages, int rows)
+{
+    PageSpec& general = spec.Add();
+    general.title = "General";
+    GeneralPageLayoutSpec(general);
+    PageSpec& network = spec.Add();
+    network.title = "Network";
+    NetworkPageLayoutSpec(network);
+
+    for(int p = 0; p < pages; p++) {
+        PageSpec& s = spec.Add();
+        s.title = Format("Section %d", p + 1);
+        s.size = Size(480, 8 + rows * 24 + 4 + 19 + 4);
+        for(int i = 0; i < rows; i++) {
+            int y = 8 + i * 24;
+            LayoutItem& l = s.item.Add();
+            l.kind = LAY_LABEL;
+            l.label = Format("Setting %d.%d", p + 1, i + 1);
+            l.x = { Ctrl::LEFT, 8, 140 };
+            l.y = { Ctrl::TOP, y, 19 };
+            LayoutItem& e = s.item.Add();
+            e.kind = 1 + i % 4;
+            e.label = "Enabled";
+            e.x = { Ctrl::SIZE, 156, 8 };
+            e.y = { Ctrl::TOP, y, 19 };
+        }
+        LayoutItem& n = s.item.Add();
+        n.kind = LAY_LABEL;
+        n.label = "Changes apply after restart";
+        n.x = { Ctrl::SIZE, 8, 8 };
+        n.y = { Ctrl::BOTTOM, 4, 19 };
+    }
+}
+
+class MyLazyDialog : public TopWindow {
+public:
+    typedef MyLazyDialog CLASSNAME;
+
+    Array<PageSpec> spec;
+    Array<LazyPage> page;
+    TabCtrl         tabs;
+    Button          ok, cancel;
+    CoWork          precompute;       // declared last: waits for the jobs before pages go away
+
+    void ShowPage() {
+        int i = tabs.Get();
+        if(i >= 0)
+            page[i].Create();
+    }
+
+    // Computes the other pages' layouts for a new page size in the background
+    void Precompute(Size sz) {
+        if(sz.cx <= 0 || sz.cy <= 0)
+            return;
+        for(PageSpec& s : spec) {
+            Size csz = ContentSize(s, sz);
+            if(!s.cache.Has(csz))
+                precompute & [&s, csz] { s.cache.Put(csz, ComputeLayout(s.item, csz)); };
+        }
+    }
+
+    int CreatedPages() const {
+        int n = 0;
+        for(const LazyPage& p : page)
+            n += p.IsCreated();
+        return n;
+    }
+
+    MyLazyDialog(int pages, int rows, bool lazy = true) {
+        Title("Lazy Dialog Example");
+        SetRect(0, 0, 520, 480);
+        Sizeable().Zoomable();
+
+        MakeSpecs(spec, pages, rows);
+        for(PageSpec& s : spec) {
+            LazyPage& p = page.Create<LazyPage>(s);
+            p.WhenNewSize = [=](Size sz) { Precompute(sz); };
+            tabs.Add(p.SizePos(), s.title);
+            if(!lazy)
+                p.Create();
+        }
+        tabs.WhenSet = THISBACK(ShowPage);
+        ShowPage();
+
+        Add(tabs.VSizePos(4, 36).HSizePos(4, 4));
+        Add(ok.SetLabel("OK").Ok().BottomPos(8, 24).RightPos(90, 76));
+        Add(cancel.SetLabel("Cancel").Cancel().BottomPos(8, 24).RightPos(8, 76));
+        ok << [=] { Accept(); };
+        cancel << [=] { Reject(); };
+    }
+};
+
+static void Benchmark()
+{
+    int pages = 20, rows = 150;
+    RLOG(Format("%d pages, %d controls", pages, pages * (2 * rows + 1)));
+    {
+        int64 t0 = usecs();
+        MyLazyDialog dlg(pages, rows, false);
+        dlg.SetRect(0, 0, 520, 480);
+        RLOG(Format("Eager open:     %8.1f ms, %d pages created", usecs(t0) / 1000.0, dlg.CreatedPages()));
+    }
+    int64 t0 = usecs();
+    MyLazyDialog lazy(pages, rows);
+    lazy.SetRect(0, 0, 520, 480);
+    RLOG(Format("Lazy open:      %8.1f ms, %d pages created", usecs(t0) / 1000.0, lazy.CreatedPages()));
+    lazy.precompute.Finish();
+
+    t0 = usecs();
+    lazy.tabs.Set(pages / 2);
+    RLOG(Format("First visit:    %8.1f ms (layout precomputed: %s)", usecs(t0) / 1000.0,
+                lazy.page[pages / 2].misses ? "no" : "yes"));
+
+    LazyPage& p = lazy.page[pages / 2];
+    t0 = usecs();
+    lazy.SetRect(0, 0, 700, 560);
+    int64 miss = usecs(t0);
+    lazy.SetRect(0, 0, 520, 480);
+    t0 = usecs();
+    lazy.SetRect(0, 0, 700, 560);
+    RLOG(Format("Relayout:       %8.3f ms computed, %.3f ms from cache (%d misses)",
+                miss / 1000.0, usecs(t0) / 1000.0, p.misses));
+}
+
+GUI_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    if(FindIndex(CommandLine(), "--bench") >= 0) {
+        Benchmark();
+        return;
+    }
+
+    MyLazyDialog dlg(20, 150);
+    if(dlg.Run() == IDOK)
+        RLOG("Dialog accepted, " << dlg.CreatedPages() << " of " << dlg.page.GetCount() << " pages were created");
+}
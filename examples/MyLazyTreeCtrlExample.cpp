@@ -0,0 +1,196 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Lazy-expanding TreeCtrl (compare with MyTreeCtrlExample.cpp, which builds the whole
+// hierarchy up front).
+//
+// Nodes are added with the "withopen" flag when they have children, so TreeCtrl shows an
+// expander without any child nodes existing yet. Opening a node (WhenOpen) adds a
+// "Loading..." placeholder and schedules the child enumeration on a CoWork worker; the
+// result is posted back to the GUI thread and replaces the placeholder. Subtrees that stay
+// collapsed longer than the idle time are freed again (RemoveChildren), leaving just the
+// expander. Startup cost is one request for the top level, and memory is proportional to
+// what the user has expanded recently.
+//
+// The hierarchy itself is synthetic (a symbol index with 100 children per level).
+
+struct SymbolEntry : Moveable<SymbolEntry> {
+    String name;
+    bool   hasChildren;
+};
+
+// Stands in for a slow symbol database lookup; called on worker threads
+static Vector<SymbolEntry> LoadSymbolChildren(const String& path)
+{
+    static const char *kind[] = { "namespace", "class", "method", "local" };
+    int depth = path.IsEmpty() ? 0 : 1;
+    for(char c : path)
+        if(c == '/')
+            depth++;
+    Sleep(20); // simulated lookup latency
+    Vector<SymbolEntry> r;
+    for(int i = 0; i < 100; i++) {
+        SymbolEntry& e = r.Add();
+        e.name = Format("%s%d", kind[min(depth, 3)], i);
+        e.hasChildren = depth < 3;
+    }
+    return r;
+}
+
+class MyLazyTreeCtrlWindow : public TopWindow {
+public:
+    typedef MyLazyTreeCtrlWindow CLASSNAME;
+
+    struct LoadResult {
+        int                 id;
+        String              path;
+        Vector<SymbolEntry> children;
+    };
+
+    struct ClosedNode : Moveable<ClosedNode> {
+        String path;
+        int    time;
+    };
+
+    TreeCtrl tree;
+    Label    status;
+    CoWork   loader;
+
+    int      idleMs;
+    int      nodeCount = 0;
+
+    Mutex             lock;
+    Array<LoadResult> results;        // finished loads, waiting for ApplyResults
+    bool              applyPosted = false;
+
+    Index<int>                 loading; // nodes with a load in flight
+    VectorMap<int, ClosedNode> closed;  // collapsed nodes, candidates for freeing
+
+    String PathOf(int id) const {
+        return id ? (String)tree.Get(id) : String();
+    }
+
+    // Ids are reused after RemoveChildren, so asynchronous results and timers identify
+    // nodes by id and path together
+    bool IsNode(int id, const String& path) const {
+        return tree.IsValid(id) && PathOf(id) == path;
+    }
+
+    void RequestChildren(int id) {
+        if(loading.Find(id) >= 0 || tree.GetChildCount(id))
+            return;
+        loading.Add(id);
+        tree.Add(id, Null, "Loading...");
+        String path = PathOf(id);
+        loader & [=] {
+            Vector<SymbolEntry> children = LoadSymbolChildren(path);
+            if(CoWork::IsCanceled())
+                return;
+            Mutex::Lock __(lock);
+            LoadResult& r = results.Add();
+            r.id = id;
+            r.path = path;
+            r.children = pick(children);
+            if(!applyPosted) {
+                applyPosted = true;
+                PostCallback(THISBACK(ApplyResults));
+            }
+        };
+    }
+
+    // GUI thread: replaces placeholders with the loaded children
+    void ApplyResults() {
+        Array<LoadResult> done;
+        {
+            Mutex::Lock __(lock);
+            done = pick(results);
+            results.Clear();
+            applyPosted = false;
+        }
+        for(LoadResult& r : done) {
+            loading.RemoveKey(r.id);
+            if(!IsNode(r.id, r.path))
+                continue; // node was freed while loading
+            tree.RemoveChildren(r.id);
+            String prefix = r.path.IsEmpty() ? String() : r.path + "/";
+            for(const SymbolEntry& e : r.children)
+                tree.Add(r.id, e.hasChildren ? CtrlImg::Dir() : CtrlImg::File(),
+                         prefix + e.name, e.name, e.hasChildren);
+            nodeCount += r.children.GetCount();
+        }
+        SyncStatus();
+    }
+
+    int CountSubtree(int id) const {
+        int n = 0;
+        for(int i = 0; i < tree.GetChildCount(id); i++)
+            n += 1 + CountSubtree(tree.GetChild(id, i));
+        return n;
+    }
+
+    void NodeOpened(int id) {
+        closed.RemoveKey(id);
+        RequestChildren(id);
+    }
+
+    void NodeClosed(int id) {
+        ClosedNode& c = closed.GetAdd(id);
+        c.path = PathOf(id);
+        c.time = msecs();
+    }
+
+    // Frees subtrees that have been collapsed for longer than idleMs
+    void Sweep() {
+        int now = msecs();
+        Vector<int> done;
+        for(int i = 0; i < closed.GetCount(); i++) {
+            int id = closed.GetKey(i);
+            const ClosedNode& c = closed[i];
+            if(!IsNode(id, c.path) || tree.IsOpen(id)) {
+                done.Add(i);  // stale: freed with an ancestor, or reopened
+                continue;
+            }
+            if(now - c.time < idleMs || loading.Find(id) >= 0)
+                continue;
+            nodeCount -= CountSubtree(id);
+            tree.RemoveChildren(id);
+            done.Add(i);
+        }
+        closed.Remove(done);
+        SyncStatus();
+    }
+
+    void SyncStatus() {
+        status.SetLabel(Format("%d nodes in memory, %d loads pending, subtrees freed after %d s idle",
+                               nodeCount, loading.GetCount(), idleMs / 1000));
+    }
+
+    MyLazyTreeCtrlWindow(int idle_ms = 10000) : idleMs(idle_ms) {
+        Title("Lazy TreeCtrl Example");
+        SetRect(0, 0, 400, 500);
+        Sizeable().Zoomable();
+
+        tree.NoRoot();
+        tree.WhenOpen = THISBACK(NodeOpened);
+        tree.WhenClose = THISBACK(NodeClosed);
+
+        Add(tree.VSizePos(0, 24).HSizePos());
+        Add(status.BottomPos(0, 24).HSizePos(4, 4));
+
+        RequestChildren(0); // the only work done at startup
+        SyncStatus();
+
+        SetTimeCallback(-1000, THISBACK(Sweep));
+    }
+
+    ~MyLazyTreeCtrlWindow() {
+        loader.Cancel();
+        loader.Finish(); // pending PostCallbacks are killed with the Ctrl
+    }
+};
+
+// Main function for the GUI application
+GUI_APP_MAIN {
+    MyLazyTreeCtrlWindow().Run();
+}
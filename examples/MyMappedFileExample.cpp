@@ -0,0 +1,154 @@
+#include "MappedFileIn.h"
+
+// Loading serialized data and text through MappedFileIn (compare with
+// MySerializationExample.cpp and the guide's Streams section).
+//
+// The same StoreToFile output is loaded three ways:
+//
+//  - LoadFromFile: FileIn, a String allocated per name
+//  - LoadFromMappedFile into the same objects: no read calls, still a String per name
+//  - LoadFromMappedFile into MySerializableObjectView: the names are MappedSlice views
+//    into the mapping, so the only allocation is the Vector itself
+//
+// MappedSlice views stored with StoreToFile are checked to load back with plain
+// LoadFromFile. Then a text file is scanned line by line with FileIn::GetLine and with
+// MappedFileIn::GetLineSlice. "--count=N" sets the number of objects (default 2M).
+
+// Same as MySerializationExample.cpp
+struct MySerializableObject : Moveable<MySerializableObject> {
+    String name;
+    int    value;
+
+    MySerializableObject() : value(0) {}
+    MySerializableObject(String n, int v) : name(n), value(v) {}
+
+    void Serialize(Stream& s) {
+        s % name % value;
+    }
+};
+
+// Loads from the same data as MySerializableObject, but only from a MappedFileIn
+struct MySerializableObjectView : Moveable<MySerializableObjectView> {
+    MappedSlice name;
+    int         value = 0;
+
+    void Serialize(Stream& s) {
+        s % name % value;
+    }
+};
+
+CONSOLE_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    int count = 2000000;
+    for(const String& a : CommandLine())
+        if(a.StartsWith("--count="))
+            count = max(1, ScanInt(a.Mid(8)));
+
+    String path = GetTempFileName();
+    {
+        Vector<MySerializableObject> data;
+        for(int i = 0; i < count; i++)
+            data.Add(MySerializableObject(Format("Object number %d", i), i));
+        if(!StoreToFile(data, path)) {
+            LOG_ERROR("Cannot write " << path);
+            return;
+        }
+    }
+    double mb = GetFileLength(path) / (1024.0 * 1024.0);
+    RLOG(Format("%d objects, %.1f MB", count, mb));
+
+    auto report = [&](const char *name, int64 t, int mem, int64 check) {
+        RLOG(Format("  %-36s %8.1f ms %8.0f MB/s %8d KB heap (check %d)",
+                    name, t / 1000.0, mb / max(t / 1e6, 1e-9), mem, check));
+    };
+
+    {
+        int mem0 = MemoryUsedKb();
+        int64 t0 = usecs();
+        Vector<MySerializableObject> data;
+        LoadFromFile(data, path);
+        int64 t = usecs(t0);
+        report("LoadFromFile", t, MemoryUsedKb() - mem0, data.GetCount() ? data.Top().value : -1);
+    }
+    {
+        int mem0 = MemoryUsedKb();
+        int64 t0 = usecs();
+        MappedFileIn in;
+        Vector<MySerializableObject> data;
+        LoadFromMappedFile(data, in, path);
+        int64 t = usecs(t0);
+        report("LoadFromMappedFile, objects", t, MemoryUsedKb() - mem0, data.GetCount() ? data.Top().value : -1);
+    }
+    {
+        int mem0 = MemoryUsedKb();
+        int64 t0 = usecs();
+        MappedFileIn in;
+        Vector<MySerializableObjectView> view;
+        LoadFromMappedFile(view, in, path);
+        int64 t = usecs(t0);
+        report("LoadFromMappedFile, views", t, MemoryUsedKb() - mem0, view.GetCount() ? view.Top().value : -1);
+        if(view.GetCount())
+            RLOG("  last view: " << view.Top().name.ToString() << " = " << view.Top().value);
+    }
+
+    // MappedSlice stores like String: views written with StoreToFile load with plain
+    // LoadFromFile, across all three length encodings
+    {
+        Vector<String> names;
+        for(int len : { 0, 5, 126, 127, 128, 200, 254, 255, 256, 100000 })
+            names.Add(String('x', len) + AsString(len));
+        Vector<MySerializableObjectView> view;
+        for(int i = 0; i < names.GetCount(); i++) {
+            MySerializableObjectView& v = view.Add();
+            v.name = MappedSlice(~names[i], names[i].GetCount());
+            v.value = i;
+        }
+        StoreToFile(view, path);
+        Vector<MySerializableObject> data;
+        bool ok = LoadFromFile(data, path) && data.GetCount() == names.GetCount();
+        for(int i = 0; ok && i < data.GetCount(); i++)
+            ok = data[i].name == names[i] && data[i].value == i;
+        MappedFileIn in;
+        Vector<MySerializableObjectView> back;
+        ok = ok && LoadFromMappedFile(back, in, path) && back.GetCount() == names.GetCount();
+        for(int i = 0; ok && i < back.GetCount(); i++)
+            ok = back[i].name.ToString() == names[i];
+        RLOG("MappedSlice stored, loaded with LoadFromFile and back: " << (ok ? "ok" : "FAILED"));
+    }
+
+    // Text lines
+    {
+        FileOut out(path);
+        for(int i = 0; i < count; i++)
+            out << "line " << i << ";value=" << i * 3 << "\n";
+    }
+    mb = GetFileLength(path) / (1024.0 * 1024.0);
+    RLOG(Format("Text file, %d lines, %.1f MB", count, mb));
+    {
+        int64 t0 = usecs();
+        FileIn in(path);
+        int64 chars = 0;
+        while(!in.IsEof())
+            chars += in.GetLine().GetCount();
+        report("FileIn::GetLine", usecs(t0), 0, chars);
+    }
+    {
+        int64 t0 = usecs();
+        MappedFileIn in(path, MAPPED_SEQUENTIAL);
+        int64 chars = 0;
+        while(!in.IsEof())
+            chars += in.GetLineSlice().GetCount();
+        report("MappedFileIn::GetLineSlice", usecs(t0), 0, chars);
+    }
+    {
+        int64 t0 = usecs();
+        MappedFileIn in(path, MAPPED_SEQUENTIAL, true);
+        int64 chars = 0;
+        while(!in.IsEof())
+            chars += in.GetLineSlice().GetCount();
+        report("MappedFileIn::GetLineSlice, huge pages", usecs(t0), 0, chars);
+    }
+    DeleteFile(path);
+    RLOG("(the files were just written and are in the page cache, so these are warm-cache numbers)");
+}
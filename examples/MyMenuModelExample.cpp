@@ -0,0 +1,256 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Prebuilt menu model for large dynamic menus (compare with MyMenuBarWindow in
+// MyMenuBarExample.cpp).
+//
+// menu.Set([=](Bar& bar) { ... }) runs the whole callback every time a menu opens: every
+// label is formatted again, every nested lambda is constructed again, and for a plugin
+// menu every item's enable / check state is queried again. MenuModel builds the item
+// tree once. Each MenuNode keeps its text, image, action and a State function that
+// computes enabled / checked; the state is cached and only recomputed for nodes that were
+// invalidated (Invalidate for one item, InvalidateAll after a bulk change). Populate
+// fills a Bar from the model, and submenus stay lazy: a submenu's children are only
+// visited when it opens.
+//
+// Bar still creates its item controls whenever a menu opens, that part is the same for
+// both approaches and is included in the timing.
+//
+// Run with "--bench" to time opening a 2000 item plugin menu both ways.
+
+struct MenuNode {
+    String           text;
+    Image            image;
+    String           help;
+    Event<>          action;
+    Function<void (bool& enabled, bool& checked)> State; // optional
+    bool             enabled = true;
+    bool             checked = false;
+    bool             checkable = false;
+    bool             dirty = true;
+    bool             separator = false;
+    Array<MenuNode>  sub;
+
+    MenuNode& Add(const char *text_, Event<> action_ = Event<>()) {
+        MenuNode& n = sub.Add();
+        n.text = text_;
+        n.action = action_;
+        return n;
+    }
+
+    MenuNode& Sub(const char *text_) {
+        MenuNode& n = sub.Add();
+        n.text = text_;
+        return n;
+    }
+
+    void Separator() { sub.Add().separator = true; }
+};
+
+class MenuModel {
+    int states = 0;     // State calls, for the statistics
+
+    void Sync(MenuNode& n) {
+        if(!n.dirty)
+            return;
+        if(n.State) {
+            n.State(n.enabled, n.checked);
+            states++;
+        }
+        n.dirty = false;
+    }
+
+    static void Mark(MenuNode& n) {
+        n.dirty = true;
+        for(MenuNode& s : n.sub)
+            Mark(s);
+    }
+
+public:
+    MenuNode root;
+
+    void Populate(Bar& bar, MenuNode& node) {
+        for(MenuNode& n : node.sub) {
+            if(n.separator) {
+                bar.Separator();
+                continue;
+            }
+            Sync(n);
+            if(n.sub.GetCount())
+                bar.Sub(n.enabled, n.text, n.image, [=, &n](Bar& b) { Populate(b, n); }).Help(n.help);
+            else {
+                Bar::Item& m = bar.Add(n.enabled, n.text, n.image, n.action).Help(n.help);
+                if(n.checkable)
+                    m.Check(n.checked);
+            }
+        }
+    }
+
+    void Populate(Bar& bar)          { Populate(bar, root); }
+
+    void Invalidate(MenuNode& n)     { n.dirty = true; }
+    void InvalidateAll()             { Mark(root); }
+
+    int  GetStateCalls() const       { return states; }
+};
+
+// Stand-in for a plugin registry: state queries cost a lookup and some formatting
+struct Plugin : Moveable<Plugin> {
+    String name;
+    String category;
+    bool   loaded = false;
+    bool   available = true;
+};
+
+struct PluginRegistry {
+    VectorMap<String, Plugin> plugin;
+
+    bool IsAvailable(const String& name) const {
+        const Plugin *p = plugin.FindPtr(name);
+        return p && p->available && Format("%s/%s", p->category, p->name).GetCount() > 0;
+    }
+
+    bool IsLoaded(const String& name) const {
+        const Plugin *p = plugin.FindPtr(name);
+        return p && p->loaded;
+    }
+
+    PluginRegistry(int categories, int per_category) {
+        for(int c = 0; c < categories; c++)
+            for(int i = 0; i < per_category; i++) {
+                String name = Format("Plugin %d.%d", c + 1, i + 1);
+                Plugin& p = plugin.Add(name);
+                p.name = name;
+                p.category = Format("Category %d", c + 1);
+                p.loaded = i % 3 == 0;
+                p.available = i % 7 != 0;
+            }
+    }
+};
+
+// The original style: the whole tree is described again on every open
+static void PluginCategoryClosure(Bar& sub, PluginRegistry& reg, int begin, int end)
+{
+    for(int j = begin; j < end; j++) {
+        String name = reg.plugin[j].name;
+        sub.Add(reg.IsAvailable(name), Format("%s...", name), [=, &reg] { reg.plugin.Get(name).loaded ^= true; })
+           .Check(reg.IsLoaded(name))
+           .Help(Format("Toggles %s", name));
+    }
+}
+
+static void PluginMenuClosure(Bar& bar, PluginRegistry& reg)
+{
+    int i = 0;
+    while(i < reg.plugin.GetCount()) {
+        String category = reg.plugin[i].category;
+        int end = i;
+        while(end < reg.plugin.GetCount() && reg.plugin[end].category == category)
+            end++;
+        bar.Sub(category, [=, &reg](Bar& sub) { PluginCategoryClosure(sub, reg, i, end); });
+        i = end;
+    }
+}
+
+// The same menu as a model under 'parent', built once
+static void BuildPluginModel(MenuModel& model, MenuNode& parent, PluginRegistry& reg)
+{
+    MenuNode *cat = nullptr;
+    for(int i = 0; i < reg.plugin.GetCount(); i++) {
+        const Plugin& p = reg.plugin[i];
+        if(!cat || cat->text != p.category)
+            cat = &parent.Sub(p.category);
+        String name = p.name;
+        MenuNode& n = cat->Add(Format("%s...", name));
+        n.help = Format("Toggles %s", name);
+        n.checkable = true;
+        n.State = [=, &reg](bool& enabled, bool& checked) {
+            enabled = reg.IsAvailable(name);
+            checked = reg.IsLoaded(name);
+        };
+        n.action = [=, &reg, &model, &n] {
+            reg.plugin.Get(name).loaded ^= true;
+            model.Invalidate(n); // only this item's state changed
+        };
+    }
+}
+
+struct MyMenuModelWindow : TopWindow {
+    MenuBar        menu;
+    PluginRegistry registry;
+    MenuModel      model;
+    Label          info;
+
+    MyMenuModelWindow() : registry(20, 100) {
+        Title("Menu Model Example");
+        SetRect(0, 0, 400, 200);
+
+        MenuNode& file = model.root.Sub("File");
+        file.Add("Reload plugin states", [=] { model.InvalidateAll(); });
+        file.Separator();
+        file.Add("Exit", [=] { Close(); }).help = "Exits the application";
+        BuildPluginModel(model, model.root.Sub("Plugins"), registry);
+
+        menu.Set([=](Bar& bar) { model.Populate(bar); });
+        AddFrame(menu);
+
+        info.SetLabel("The Plugins menu is built once; states are cached per item");
+        info.AlignCenter();
+        Add(info.SizePos());
+    }
+};
+
+template <class Fn>
+static double OpenMs(int reps, Fn fn)
+{
+    int64 t0 = usecs();
+    for(int i = 0; i < reps; i++)
+        fn();
+    return usecs(t0) / 1000.0 / reps;
+}
+
+GUI_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    if(FindIndex(CommandLine(), "--bench") >= 0) {
+        PluginRegistry reg(20, 100);
+        MenuModel model;
+        BuildPluginModel(model, model.root, reg);
+        int reps = 20;
+
+        // Opening a category: the top level is filled again, then the category's submenu
+        auto closure_category = [&](int c) {
+            MenuBar top;
+            PluginMenuClosure(top, reg);
+            MenuBar sub;
+            PluginCategoryClosure(sub, reg, 100 * c, 100 * c + 100);
+        };
+        auto model_category = [&](int c) {
+            MenuBar top;
+            model.Populate(top);
+            MenuBar sub;
+            model.Populate(sub, model.root.sub[c]);
+        };
+
+        double closure_ms = OpenMs(reps, [&] { for(int c = 0; c < 20; c++) closure_category(c); });
+        model.InvalidateAll();
+        double model_cold = OpenMs(1, [&] { for(int c = 0; c < 20; c++) model_category(c); });
+        int calls0 = model.GetStateCalls();
+        double model_ms = OpenMs(reps, [&] { for(int c = 0; c < 20; c++) model_category(c); });
+        reg.plugin[5].loaded ^= true;
+        model.Invalidate(model.root.sub[0].sub[5]);
+        double model_one = OpenMs(1, [&] { for(int c = 0; c < 20; c++) model_category(c); });
+
+        RLOG("Opening all 20 submenus of a 2000 item plugin menu:");
+        RLOG(Format("  closure rebuilt per open: %8.2f ms", closure_ms));
+        RLOG(Format("  model, all states dirty:  %8.2f ms", model_cold));
+        RLOG(Format("  model, cached states:     %8.2f ms (%d state calls after the first open)",
+                    model_ms, model.GetStateCalls() - calls0));
+        RLOG(Format("  model, one item changed:  %8.2f ms", model_one));
+        RLOG(Format("  speedup with cached states %.2fx", closure_ms / model_ms));
+        return;
+    }
+
+    MyMenuModelWindow().Run();
+}
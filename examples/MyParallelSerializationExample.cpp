@@ -0,0 +1,212 @@
+#include <Core/Core.h>
+
+using namespace Upp;
+
+// Parallel serialization of large containers (compare with MySerializationExample.cpp).
+//
+// Serialize(Stream&) is sequential, so StoreToFile / LoadFromFile of a big Vector run on
+// one core. StoreBlocked splits the Vector into blocks of 'block_size' elements and
+// encodes them in parallel with CoPartition. The blocks are written inside a regular
+// StoreToFile callback, after the element count, so the file is byte for byte what
+// StoreToFile(vector) writes and any existing LoadFromFile(vector) still reads it
+// sequentially. An index of block offsets and a footer are appended after that:
+//
+//   StoreToFile envelope   count, block 0, block 1, ... (the elements back to back)
+//   BlockIndexEntry[]      file offset, length, first element and element count per block
+//   BlockFooter            index offset, block count, element count, magic
+//
+// LoadBlocked maps the file, reads the footer and decodes all blocks in parallel straight
+// from the mapping into a pre-sized Vector. Files without the footer are loaded with
+// LoadFromFile. Encoded blocks are kept in memory until they are written, like
+// StoreAsString would keep the whole stream.
+
+struct BlockIndexEntry {
+    int64 pos;
+    int64 len;
+    int   first;
+    int   count;
+};
+
+struct BlockFooter {
+    int64 index_pos;
+    int   blocks;
+    int   count;
+    dword magic;
+    dword version;
+};
+
+static const dword block_footer_magic = 0x58444942; // "BIDX"
+
+static_assert(sizeof(BlockIndexEntry) == 24, "unexpected padding in BlockIndexEntry");
+static_assert(sizeof(BlockFooter) == 24, "unexpected padding in BlockFooter");
+
+// Calls fn(i) for every block, on CoWork workers unless 'parallel' is false
+template <class Fn>
+static void ForEachBlock(int blocks, bool parallel, const Fn& fn)
+{
+    if(parallel)
+        CoPartition(0, blocks, [&](int lo, int hi) {
+            for(int i = lo; i < hi; i++)
+                fn(i);
+        });
+    else
+        for(int i = 0; i < blocks; i++)
+            fn(i);
+}
+
+template <class T>
+bool StoreBlocked(Vector<T>& data, const char *path, int block_size = 65536, bool parallel = true)
+{
+    int count = data.GetCount();
+    int blocks = (count + block_size - 1) / block_size;
+    Vector<String> encoded;
+    encoded.SetCount(blocks);
+    ForEachBlock(blocks, parallel, [&](int i) {
+        StringStream ss;
+        int end = min(count, (i + 1) * block_size);
+        for(int j = i * block_size; j < end; j++)
+            ss % data[j];
+        encoded[i] = ss.GetResult();
+    });
+
+    Vector<BlockIndexEntry> index;
+    if(!StoreToFile([&](Stream& s) {
+        int n = count;
+        s / n; // the same count prefix Vector::Serialize writes
+        for(int i = 0; i < blocks; i++) {
+            BlockIndexEntry& e = index.Add();
+            e.pos = s.GetPos();
+            e.len = encoded[i].GetCount();
+            e.first = i * block_size;
+            e.count = min(count, (i + 1) * block_size) - e.first;
+            s.Put(encoded[i]);
+            encoded[i].Clear();
+        }
+    }, path))
+        return false;
+
+    FileAppend out(path);
+    if(!out)
+        return false;
+    BlockFooter f;
+    f.index_pos = out.GetSize();
+    f.blocks = index.GetCount();
+    f.count = count;
+    f.magic = block_footer_magic;
+    f.version = 1;
+    out.Put(index.begin(), index.GetCount() * sizeof(BlockIndexEntry));
+    out.Put(&f, sizeof(f));
+    out.Close();
+    return !out.IsError();
+}
+
+template <class T>
+bool LoadBlocked(Vector<T>& data, const char *path, bool parallel = true)
+{
+    FileMapping map;
+    if(!map.Open(path) || !map.Map(0, (size_t)map.GetFileSize()))
+        return false;
+    int64 size = map.GetFileSize();
+    BlockFooter f;
+    if(size >= (int64)sizeof(f))
+        memcpy(&f, map.Begin() + size - sizeof(f), sizeof(f));
+    if(size < (int64)sizeof(f) || f.magic != block_footer_magic || f.blocks < 0 || f.index_pos < 0 ||
+       f.index_pos + (int64)f.blocks * (int64)sizeof(BlockIndexEntry) != size - (int64)sizeof(f)) {
+        map.Close();
+        return LoadFromFile(data, path); // written by plain StoreToFile
+    }
+    const BlockIndexEntry *index = (const BlockIndexEntry *)(map.Begin() + f.index_pos);
+    int64 total = 0;
+    for(int i = 0; i < f.blocks; i++) {
+        const BlockIndexEntry& e = index[i];
+        if(e.pos < 0 || e.len < 0 || e.pos + e.len > f.index_pos || e.first != total || e.count < 0)
+            return false;
+        total += e.count;
+    }
+    if(total != f.count)
+        return false;
+
+    data.Clear();
+    data.SetCount(f.count);
+    std::atomic<bool> error(false);
+    ForEachBlock(f.blocks, parallel, [&](int i) {
+        const BlockIndexEntry& e = index[i];
+        MemReadStream ss(map.Begin() + e.pos, e.len);
+        for(int j = 0; j < e.count && !ss.IsError(); j++)
+            ss % data[e.first + j];
+        if(ss.IsError())
+            error = true;
+    });
+    if(error)
+        data.Clear();
+    return !error;
+}
+
+// Same as MySerializationExample.cpp
+struct MySerializableObject : Moveable<MySerializableObject> {
+    String name;
+    int    value;
+
+    MySerializableObject() : value(0) {}
+    MySerializableObject(String n, int v) : name(n), value(v) {}
+
+    void Serialize(Stream& s) {
+        s % name % value;
+    }
+
+    String ToString() const {
+        return Sprintf("Name: %s, Value: %d", name, value);
+    }
+};
+
+CONSOLE_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    int count = 10000000;
+    for(const String& a : CommandLine())
+        if(a.StartsWith("--count="))
+            count = StrInt(a.Mid(8));
+
+    Vector<MySerializableObject> data;
+    data.SetCount(count);
+    CoPartition(0, count, [&](int lo, int hi) {
+        for(int i = lo; i < hi; i++)
+            data[i] = MySerializableObject(Format("Checkpoint object %d", i), i);
+    });
+
+    String plain = GetTempFileName();
+    String blocked = GetTempFileName();
+
+    int64 t0 = usecs();
+    StoreToFile(data, plain);
+    double t_store = usecs(t0) / 1000.0;
+    t0 = usecs();
+    Vector<MySerializableObject> loaded;
+    LoadFromFile(loaded, plain);
+    double t_load = usecs(t0) / 1000.0;
+    RLOG(Format("StoreToFile / LoadFromFile: %8.0f / %8.0f ms, %d objects", t_store, t_load, count));
+
+    for(int threads : { 1, 4, 16 }) {
+        if(threads > 1)
+            CoWork::SetPoolSize(threads - 1); // the calling thread takes part too
+        t0 = usecs();
+        StoreBlocked(data, blocked, 65536, threads > 1);
+        double t_s = usecs(t0) / 1000.0;
+        t0 = usecs();
+        bool ok = LoadBlocked(loaded, blocked, threads > 1);
+        double t_l = usecs(t0) / 1000.0;
+        RLOG(Format("Blocked, %2d threads:        %8.0f / %8.0f ms, speedup %.2fx / %.2fx%s",
+                    threads, t_s, t_l, t_store / t_s, t_load / t_l, ok ? "" : ", load failed"));
+    }
+    ASSERT(loaded.GetCount() == count && loaded.Top().value == count - 1);
+
+    // Older readers still load the blocked file sequentially
+    Vector<MySerializableObject> old;
+    bool ok = LoadFromFile(old, blocked);
+    RLOG("LoadFromFile of the blocked file: " << (ok && old.GetCount() == count ? "ok" : "FAILED"));
+    if(ok && old.GetCount())
+        DUMP(old[count / 2]);
+
+    DeleteFile(plain);
+    DeleteFile(blocked);
+}
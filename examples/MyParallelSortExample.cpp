@@ -0,0 +1,143 @@
+#include "ParallelSort.h"
+
+// Scaling of ParallelSort, RadixSort and FastFindIndex (see ParallelSort.h; compare with
+// Sort, FindIndex and SubRange in the guide's "Ranges and Algorithms" section).
+//
+// For 1...64 threads the same random data is sorted with CoSort, ParallelSort and
+// RadixSort; the single thread row is Sort. The pool is resized with CoWork::SetPoolSize,
+// so thread counts above the number of cores show the cost of oversubscription rather
+// than more speed. Then FindIndex and FastFindIndex look for a value near the end of a
+// large Vector. "--count=N" sets the number of elements (default 20M).
+
+// A record sorted by a fixed-width key, the radix sort case besides plain integers
+struct SortRecord : Moveable<SortRecord> {
+    uint64 key;
+    int    payload;
+
+    bool operator<(const SortRecord& b) const { return key < b.key; }
+};
+
+template <class Range, class Less>
+static bool IsSortedBy(const Range& r, const Less& less)
+{
+    auto s = r.begin();
+    for(int i = 1; i < r.GetCount(); i++)
+        if(less(s[i], s[i - 1]))
+            return false;
+    return true;
+}
+
+// Best of 'reps' runs of sort(work), each on a fresh copy of 'data'
+template <class T, class Fn>
+static double SortMs(const Vector<T>& data, int reps, Fn sort)
+{
+    double best = 1e30;
+    for(int r = 0; r < reps; r++) {
+        Vector<T> work = clone(data);
+        int64 t0 = usecs();
+        sort(work);
+        best = min(best, usecs(t0) / 1000.0);
+        if(!IsSortedBy(work, std::less<T>()))
+            RLOG("  NOT SORTED");
+    }
+    return best;
+}
+
+template <class T, class Radix>
+static void SortScaling(const char *name, const Vector<T>& data, Radix radix)
+{
+    RLOG(Format("%s, %d elements:", name, data.GetCount()));
+    RLOG("  threads    CoSort ParallelSort  RadixSort   (ms, speedup against Sort)");
+    double base = SortMs(data, 2, [](Vector<T>& v) { Sort(v); });
+    RLOG(Format("  %7d %9.1f %12s %10s   (Sort)", 1, base, "", ""));
+    for(int threads = 2; threads <= 64; threads *= 2) {
+        CoWork::SetPoolSize(threads - 1); // the calling thread takes part too
+        double co = SortMs(data, 2, [](Vector<T>& v) { CoSort(v); });
+        double ps = SortMs(data, 2, [](Vector<T>& v) { ParallelSort(v); });
+        double rs = SortMs(data, 2, radix);
+        RLOG(Format("  %7d %9.1f %12.1f %10.1f   (%.1fx %.1fx %.1fx)",
+                    threads, co, ps, rs, base / co, base / ps, base / rs));
+    }
+    CoWork::SetPoolSize(CPU_Cores());
+}
+
+template <class T>
+static void FindScaling(const char *name, int count)
+{
+    Vector<T> v;
+    v.SetCount(count, T(1));
+    v[count - 3] = T(7);
+    double mb = count * sizeof(T) / (1024.0 * 1024.0);
+    int found = -1;
+    int64 t0 = usecs();
+    for(int r = 0; r < 10; r++)
+        found = FindIndex(v, T(7));
+    double t_plain = usecs(t0) / 10.0;
+    int found_fast = -1;
+    t0 = usecs();
+    for(int r = 0; r < 10; r++)
+        found_fast = FastFindIndex(v, T(7));
+    double t_fast = usecs(t0) / 10.0;
+    RLOG(Format("  %-7s FindIndex %7.0f MB/s, FastFindIndex %7.0f MB/s, %.1fx%s",
+                name, mb / (t_plain / 1e6), mb / (t_fast / 1e6), t_plain / t_fast,
+                found == found_fast && found == count - 3 ? "" : ", MISMATCH"));
+}
+
+CONSOLE_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    int count = 20000000;
+    for(const String& a : CommandLine())
+        if(a.StartsWith("--count="))
+            count = max(1000, ScanInt(a.Mid(8)));
+
+    // Ranges work like with Sort: only the middle of the Vector is sorted here
+    Vector<int> small;
+    for(int i = 0; i < 300000; i++)
+        small.Add(Random());
+    ParallelSort(SubRange(small, 1000, small.GetCount() - 2000));
+    RadixSort(SubRange(small, 1000, small.GetCount() - 2000));
+    RLOG("SubRange sorted: " << IsSortedBy(SubRange(small, 1000, small.GetCount() - 2000), std::less<int>()));
+
+    Vector<int> ints;
+    ints.SetCount(count);
+    for(int& x : ints)
+        x = (int)Random();
+    SortScaling("int", ints, [](Vector<int>& v) { RadixSort(v); });
+
+    Vector<double> reals;
+    reals.SetCount(count);
+    for(double& x : reals)
+        x = Randomf() * 2e6 - 1e6;
+    SortScaling("double", reals, [](Vector<double>& v) { RadixSort(v); });
+
+    Vector<SortRecord> records;
+    records.SetCount(count / 2);
+    for(int i = 0; i < records.GetCount(); i++) {
+        records[i].key = Random64();
+        records[i].payload = i;
+    }
+    SortScaling("SortRecord (uint64 key + payload)", records,
+                [](Vector<SortRecord>& v) { RadixSort(v, [](const SortRecord& r) { return r.key; }); });
+
+    // Needles of another type are compared like FindIndex does, in the common type
+    Vector<float> floats = { 1.0f, 16777216.0f, 2.5f };
+    Vector<int> small_ints = { 1, -1, 7 };
+    Vector<int64> big_ints = { 1, ((int64)1 << 53), ((int64)1 << 53) + 1 };
+    bool agree = FastFindIndex(floats, 16777217) == FindIndex(floats, 16777217) &&
+                 FastFindIndex(floats, 2.5) == FindIndex(floats, 2.5) &&
+                 FastFindIndex(small_ints, 1e20) == FindIndex(small_ints, 1e20) &&
+                 FastFindIndex(small_ints, NAN) == FindIndex(small_ints, NAN) &&
+                 FastFindIndex(small_ints, 7.5) == FindIndex(small_ints, 7.5) &&
+                 FastFindIndex(small_ints, 0xffffffffu) == FindIndex(small_ints, 0xffffffffu) &&
+                 FastFindIndex(big_ints, 9007199254740993.0) == FindIndex(big_ints, 9007199254740993.0);
+    RLOG("FastFindIndex agrees with FindIndex for mixed needles: " << agree);
+
+    RLOG("Linear search for a value near the end:");
+    FindScaling<byte>("byte", count);
+    FindScaling<int16>("int16", count);
+    FindScaling<int>("int", count);
+    FindScaling<int64>("int64", count);
+    FindScaling<float>("float", count);
+    FindScaling<double>("double", count);
+}
@@ -0,0 +1,220 @@
+#include <Core/Core.h>
+
+using namespace Upp;
+
+// Partition strategies for uneven parallel loops (see MyCoPartitionExample.cpp).
+//
+// CoPartition splits a range into roughly equal pieces up front. That is ideal when every
+// element costs the same, but with skewed work (the stringItems loop with very different
+// string lengths, or a batch where a few records are expensive) the threads that got the
+// cheap pieces finish early and sit idle. ParallelFor takes a PartitionPolicy per call:
+//
+//  PARTITION_DEFAULT   plain CoPartition
+//  PARTITION_FIXED     one CoWork job per 'grain' elements
+//  PARTITION_GUIDED    workers take shrinking chunks (remaining / 2P, at least 'grain')
+//                      from a shared counter
+//  PARTITION_STEALING  each worker owns an equal slice and takes 'grain' elements at a time
+//                      from its front; a worker that runs dry steals the back half of
+//                      another worker's remaining slice
+//
+// The benchmark runs a loop with skewed per-element cost under each strategy and a few
+// grain sizes.
+
+enum {
+    PARTITION_DEFAULT,
+    PARTITION_FIXED,
+    PARTITION_GUIDED,
+    PARTITION_STEALING,
+};
+
+struct PartitionPolicy {
+    int strategy;
+    int grain;    // elements per chunk (FIXED, STEALING) or minimal chunk (GUIDED)
+
+    PartitionPolicy(int strategy = PARTITION_DEFAULT, int grain = 1024)
+    :   strategy(strategy), grain(max(grain, 1)) {}
+};
+
+inline PartitionPolicy PartitionFixed(int grain)    { return PartitionPolicy(PARTITION_FIXED, grain); }
+inline PartitionPolicy PartitionGuided(int grain)   { return PartitionPolicy(PARTITION_GUIDED, grain); }
+inline PartitionPolicy PartitionStealing(int grain) { return PartitionPolicy(PARTITION_STEALING, grain); }
+
+// Work-stealing slot: the remaining [lo, hi) of one worker packed into a single atomic
+// so owner and thieves can update it with one compare-exchange
+struct StealSlot {
+    std::atomic<int64> range;
+    byte               pad[56]; // keep slots on separate cache lines
+
+    static int64 Pack(int lo, int hi) { return ((int64)hi << 32) | (uint32)lo; }
+    static int   Lo(int64 r)          { return (int)(uint32)r; }
+    static int   Hi(int64 r)          { return (int)(r >> 32); }
+};
+
+// Takes up to 'grain' elements from the front of the owner's slot
+static bool TakeOwn(StealSlot& s, int grain, int& lo, int& hi)
+{
+    int64 r = s.range.load();
+    for(;;) {
+        int l = StealSlot::Lo(r), h = StealSlot::Hi(r);
+        if(l >= h)
+            return false;
+        int e = min(h, l + grain);
+        if(s.range.compare_exchange_weak(r, StealSlot::Pack(e, h))) {
+            lo = l;
+            hi = e;
+            return true;
+        }
+    }
+}
+
+// Moves the back half of the victim's remaining range into the thief's empty slot
+static bool Steal(StealSlot& victim, StealSlot& thief, int grain)
+{
+    int64 r = victim.range.load();
+    for(;;) {
+        int l = StealSlot::Lo(r), h = StealSlot::Hi(r);
+        if(h - l < 2 * grain)
+            return false; // not worth splitting, the owner will finish it
+        int mid = l + (h - l) / 2;
+        if(victim.range.compare_exchange_weak(r, StealSlot::Pack(l, mid))) {
+            thief.range.store(StealSlot::Pack(mid, h));
+            return true;
+        }
+    }
+}
+
+// Calls fn(lo, hi) for pieces of [begin, end) according to 'policy'
+template <class Fn>
+void ParallelFor(int begin, int end, const Fn& fn, PartitionPolicy policy = PartitionPolicy())
+{
+    if(begin >= end)
+        return;
+    int grain = policy.grain;
+    int workers = CoWork::GetPoolSize() + 1; // the calling thread works too
+    switch(policy.strategy) {
+    case PARTITION_FIXED: {
+        CoWork co;
+        for(int lo = begin; lo < end; lo += grain) {
+            int hi = min(end, lo + grain);
+            co & [=, &fn] { fn(lo, hi); };
+        }
+        break;
+    }
+    case PARTITION_GUIDED: {
+        std::atomic<int> next(begin);
+        CoWork co;
+        for(int w = 0; w < workers; w++)
+            co & [&] {
+                int lo = next.load();
+                while(lo < end) {
+                    int chunk = min(end - lo, max(grain, (end - lo) / (2 * workers)));
+                    if(next.compare_exchange_weak(lo, lo + chunk)) {
+                        fn(lo, lo + chunk);
+                        lo = next.load();
+                    }
+                }
+            };
+        break;
+    }
+    case PARTITION_STEALING: {
+        Buffer<StealSlot> slot(workers);
+        int64 n = end - begin;
+        for(int w = 0; w < workers; w++)
+            slot[w].range.store(StealSlot::Pack(int(begin + n * w / workers),
+                                                int(begin + n * (w + 1) / workers)));
+        CoWork co;
+        for(int w = 0; w < workers; w++)
+            co & [&, w] {
+                for(;;) {
+                    int lo, hi;
+                    while(TakeOwn(slot[w], grain, lo, hi))
+                        fn(lo, hi);
+                    bool stolen = false;
+                    for(int i = 1; i < workers && !stolen; i++)
+                        stolen = Steal(slot[(w + i) % workers], slot[w], grain);
+                    if(!stolen)
+                        return;
+                }
+            };
+        break;
+    }
+    default:
+        CoPartition(begin, end, fn);
+    }
+}
+
+// Range version, fn receives a SubRange like CoPartition's lambda
+template <class Range, class Fn>
+void ParallelFor(Range& r, const Fn& fn, PartitionPolicy policy = PartitionPolicy())
+{
+    ParallelFor(0, r.GetCount(), [&](int lo, int hi) { fn(SubRange(r, lo, hi - lo)); }, policy);
+}
+
+// Skewed per-element cost: one element in 64 is 200x more expensive, and they are clustered
+// in the first quarter, which is where CoPartition puts the first thread
+static int ElementCost(int i, int count)
+{
+    return i < count / 4 && (i & 63) == 0 ? 2000 : 10;
+}
+
+static double Work(int i, int cost)
+{
+    double acc = 0;
+    for(int k = 0; k < cost; k++)
+        acc += sqrt((double)(i + k));
+    return acc;
+}
+
+CONSOLE_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    // Like the stringItems loop from MyCoPartitionExample.cpp, but with very uneven items
+    Vector<String> stringItems;
+    for(int i = 0; i < 64; i++)
+        stringItems.Add(String('x', i % 8 == 0 ? 100000 : 10));
+    std::atomic<int64> chars(0);
+    ParallelFor(stringItems, [&](const auto& subrange) {
+        int64 n = 0;
+        for(const String& item : subrange)
+            n += item.GetCount();
+        chars += n;
+    }, PartitionGuided(1));
+    LOG("Characters processed: " << (int64)chars);
+
+    int count = 1 << 20;
+    Vector<double> out;
+    out.SetCount(count);
+    auto body = [&](int lo, int hi) {
+        for(int i = lo; i < hi; i++)
+            out[i] = Work(i, ElementCost(i, count));
+    };
+
+    struct Case { const char *name; int strategy; };
+    Case cases[] = {
+        { "CoPartition", PARTITION_DEFAULT },
+        { "Fixed",       PARTITION_FIXED },
+        { "Guided",      PARTITION_GUIDED },
+        { "Stealing",    PARTITION_STEALING },
+    };
+
+    RLOG("Workers: " << CoWork::GetPoolSize() + 1 << ", elements: " << count);
+    int64 t0 = usecs();
+    body(0, count);
+    double sequential = usecs(t0) / 1000.0;
+    RLOG(Format("Sequential: %.1f ms", sequential));
+
+    for(const Case& c : cases)
+        for(int grain : { 16, 256, 4096 }) {
+            if(c.strategy == PARTITION_DEFAULT && grain != 16)
+                continue; // CoPartition has no grain
+            int64 best = INT64_MAX;
+            for(int rep = 0; rep < 5; rep++) {
+                int64 t1 = usecs();
+                ParallelFor(0, count, body, PartitionPolicy(c.strategy, grain));
+                best = min(best, usecs(t1));
+            }
+            RLOG(Format("%-12s grain %5d: %8.2f ms, speedup %.2fx", c.name,
+                        c.strategy == PARTITION_DEFAULT ? 0 : grain,
+                        best / 1000.0, sequential / (best / 1000.0)));
+        }
+}
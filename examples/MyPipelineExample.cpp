@@ -0,0 +1,308 @@
+#include <Core/Core.h>
+
+using namespace Upp;
+
+// Streaming pipeline on CoWork: read -> parse -> transform -> store.
+//
+// Chaining CoWork batches with a full barrier between stages means the file is read
+// completely before any parsing starts, and so on: the total time is the sum of all stages.
+// Here the stages are connected by bounded lock-free queues and run concurrently, so while
+// the reader waits for I/O the parsers work on the previous batch. Each stage has its own
+// number of workers, and a full queue blocks its producers (back-pressure), which keeps
+// memory bounded no matter how fast the reader is. Throughput approaches the slowest stage.
+//
+// Items are whole batches of lines or records, so queue traffic is per batch, not per line.
+
+// Bounded multi-producer / multi-consumer queue (D. Vyukov's array queue). Capacity must be
+// a power of two. The queue closes when the last registered producer calls ProducerDone;
+// Pop then drains what is left and returns false.
+template <class T>
+class BoundedQueue : NoCopy {
+    struct Cell {
+        std::atomic<int64> seq;
+        T                  data;
+    };
+
+    Buffer<Cell>       cell;
+    int64              mask;
+    byte               pad0[64];
+    std::atomic<int64> enqueue_pos;
+    byte               pad1[64];
+    std::atomic<int64> dequeue_pos;
+    byte               pad2[64];
+    std::atomic<int>   producers;
+    std::atomic<int>   full_waits;
+
+    static void Backoff(int& spins) {
+        if(++spins > 64)
+            Sleep(spins > 1024 ? 1 : 0);
+    }
+
+public:
+    bool TryPush(T& x) {
+        int64 pos = enqueue_pos.load(std::memory_order_relaxed);
+        for(;;) {
+            Cell& c = cell[pos & mask];
+            int64 dif = c.seq.load(std::memory_order_acquire) - pos;
+            if(dif == 0) {
+                if(enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.data = pick(x);
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else
+            if(dif < 0)
+                return false; // full
+            else
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool TryPop(T& x) {
+        int64 pos = dequeue_pos.load(std::memory_order_relaxed);
+        for(;;) {
+            Cell& c = cell[pos & mask];
+            int64 dif = c.seq.load(std::memory_order_acquire) - (pos + 1);
+            if(dif == 0) {
+                if(dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    x = pick(c.data);
+                    c.seq.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else
+            if(dif < 0)
+                return false; // empty
+            else
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Blocks while the queue is full
+    void Push(T& x) {
+        int spins = 0;
+        if(TryPush(x))
+            return;
+        full_waits++;
+        while(!TryPush(x))
+            Backoff(spins);
+    }
+
+    // Blocks while the queue is empty; false when closed and drained
+    bool Pop(T& x) {
+        int spins = 0;
+        for(;;) {
+            if(TryPop(x))
+                return true;
+            if(producers.load() == 0)
+                return TryPop(x);
+            Backoff(spins);
+        }
+    }
+
+    void AddProducers(int n)       { producers += n; }
+    void ProducerDone()            { producers--; }
+    int  GetFullWaits() const      { return full_waits; }
+
+    BoundedQueue(int capacity = 64) : cell(capacity) {
+        ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0);
+        mask = capacity - 1;
+        for(int i = 0; i < capacity; i++)
+            cell[i].seq.store(i);
+        enqueue_pos = dequeue_pos = 0;
+        producers = 0;
+        full_waits = 0;
+    }
+};
+
+// Set of stages connected by BoundedQueues. Stages are declared first, Run schedules every
+// stage worker as a long-running CoWork job (growing the pool if needed, as blocked stage
+// workers must not starve each other) and runs the source on the calling thread.
+class Pipeline : NoCopy {
+    Vector<Function<void ()>> jobs;
+
+public:
+    // 'parallel' workers call fn(in_item, out_item) and forward out_item when fn returns true
+    template <class In, class Out, class Fn>
+    void Stage(BoundedQueue<In>& in, BoundedQueue<Out>& out, int parallel, Fn fn) {
+        out.AddProducers(parallel);
+        for(int i = 0; i < parallel; i++)
+            jobs.Add([=, &in, &out] {
+                In a;
+                while(in.Pop(a)) {
+                    Out b;
+                    if(fn(a, b))
+                        out.Push(b);
+                }
+                out.ProducerDone();
+            });
+    }
+
+    // Final stage, fn(in_item) consumes the item
+    template <class In, class Fn>
+    void Sink(BoundedQueue<In>& in, int parallel, Fn fn) {
+        for(int i = 0; i < parallel; i++)
+            jobs.Add([=, &in] {
+                In a;
+                while(in.Pop(a))
+                    fn(a);
+            });
+    }
+
+    // source(queue) pushes every input item into 'first'; returns when all stages are done
+    template <class T, class Source>
+    void Run(BoundedQueue<T>& first, Source source) {
+        if(jobs.GetCount() > CoWork::GetPoolSize())
+            CoWork::SetPoolSize(jobs.GetCount());
+        first.AddProducers(1);
+        CoWork co;
+        for(Function<void ()>& job : jobs)
+            co & job;
+        source(first);
+        first.ProducerDone();
+        co.Finish();
+        jobs.Clear();
+    }
+};
+
+struct Record : Moveable<Record> {
+    int    id = 0;
+    String name;
+    double value = 0;
+    dword  hash = 0;
+};
+
+typedef Vector<String> LineBatch;
+typedef Vector<Record> RecordBatch;
+
+static bool ParseBatch(LineBatch& lines, RecordBatch& out)
+{
+    out.Reserve(lines.GetCount());
+    for(const String& l : lines) {
+        Vector<String> f = Split(l, ';');
+        if(f.GetCount() != 3)
+            continue;
+        Record& r = out.Add();
+        r.id = StrInt(f[0]);
+        r.name = f[1];
+        r.value = StrDbl(f[2]);
+    }
+    return out.GetCount();
+}
+
+static bool TransformBatch(RecordBatch& in, RecordBatch& out)
+{
+    for(Record& r : in) {
+        double v = r.value;
+        for(int i = 0; i < 50; i++) // stands in for real per-record computation
+            v = sqrt(v * v + i);
+        r.value = v;
+        r.hash = GetHashValue(r.name) ^ r.id;
+    }
+    out = pick(in);
+    return true;
+}
+
+struct Totals {
+    VectorMap<String, double> byName;
+    int64                     records = 0;
+
+    void Store(const RecordBatch& batch) {
+        for(const Record& r : batch)
+            byName.GetAdd(r.name, 0) += r.value;
+        records += batch.GetCount();
+    }
+};
+
+static String CreateInputFile(int lines)
+{
+    String path = GetTempFileName();
+    FileOut out(path);
+    for(int i = 0; i < lines; i++)
+        out << i << ';' << "name" << i % 1000 << ';' << i * 0.25 << '\n';
+    return path;
+}
+
+static bool ReadBatch(FileIn& in, LineBatch& batch, int lines = 4096)
+{
+    batch.Clear();
+    while(batch.GetCount() < lines && !in.IsEof())
+        batch.Add(in.GetLine());
+    return batch.GetCount();
+}
+
+CONSOLE_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    int lines = 2000000;
+    String path = CreateInputFile(lines);
+    RLOG("Input: " << path << ", " << GetFileLength(path) / 1024 / 1024 << " MB, " << lines << " lines");
+
+    // Barrier version: every stage finishes before the next starts
+    double t_read, t_parse, t_transform, t_store, t_barrier;
+    {
+        int64 t0 = usecs();
+        Vector<LineBatch> batches;
+        FileIn in(path);
+        LineBatch b;
+        while(ReadBatch(in, b))
+            batches.Add(pick(b));
+        t_read = usecs(t0) / 1e3;
+
+        int64 t1 = usecs();
+        Vector<RecordBatch> records;
+        records.SetCount(batches.GetCount());
+        CoPartition(0, batches.GetCount(), [&](int lo, int hi) {
+            for(int i = lo; i < hi; i++)
+                ParseBatch(batches[i], records[i]);
+        });
+        t_parse = usecs(t1) / 1e3;
+
+        t1 = usecs();
+        Vector<RecordBatch> transformed;
+        transformed.SetCount(records.GetCount());
+        CoPartition(0, records.GetCount(), [&](int lo, int hi) {
+            for(int i = lo; i < hi; i++)
+                TransformBatch(records[i], transformed[i]);
+        });
+        t_transform = usecs(t1) / 1e3;
+
+        t1 = usecs();
+        Totals totals;
+        for(const RecordBatch& r : transformed)
+            totals.Store(r);
+        t_store = usecs(t1) / 1e3;
+        t_barrier = usecs(t0) / 1e3;
+        RLOG(Format("Barrier:  %.0f ms (read %.0f, parse %.0f, transform %.0f, store %.0f), %d records",
+                    t_barrier, t_read, t_parse, t_transform, t_store, totals.records));
+    }
+
+    // Pipelined version
+    {
+        int64 t0 = usecs();
+        BoundedQueue<LineBatch>   lineQueue(32);
+        BoundedQueue<RecordBatch> parsed(32);
+        BoundedQueue<RecordBatch> transformed(32);
+        Totals totals;
+
+        int cpus = max(CPU_Cores() - 2, 2);
+        Pipeline p;
+        p.Stage(lineQueue, parsed, cpus / 2, ParseBatch);
+        p.Stage(parsed, transformed, cpus - cpus / 2, TransformBatch);
+        p.Sink(transformed, 1, [&](RecordBatch& r) { totals.Store(r); });
+        p.Run(lineQueue, [&](BoundedQueue<LineBatch>& q) {
+            FileIn in(path);
+            LineBatch b;
+            while(ReadBatch(in, b))
+                q.Push(b);
+        });
+        double t = usecs(t0) / 1e3;
+        RLOG(Format("Pipeline: %.0f ms, %d records, slowest barrier stage %.0f ms, back-pressure waits %d/%d/%d",
+                    t, totals.records, max(max(t_read, t_parse), max(t_transform, t_store)),
+                    lineQueue.GetFullWaits(), parsed.GetFullWaits(), transformed.GetFullWaits()));
+        RLOG(Format("Speedup over barrier chain: %.2fx", t_barrier / t));
+    }
+
+    DeleteFile(path);
+}
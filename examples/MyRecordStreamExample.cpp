@@ -0,0 +1,316 @@
+#include <Core/Core.h>
+#include <plugin/lz4/lz4.h>
+#include <plugin/zstd/zstd.h>
+
+using namespace Upp;
+
+// Streaming record files (compare with MySerializationExample.cpp).
+//
+// StoreToFile(x) serializes the whole object graph at once, so a large collection has to
+// be complete in memory before anything is written, and LoadFromFile gives the reader
+// nothing until the whole file is loaded. RecordWriter appends objects one at a time
+// instead; they are serialized into a chunk buffer which is written as a framed chunk,
+// optionally compressed with LZ4 or zstd, once it reaches the chunk size:
+//
+//   RecordChunkHeader   magic, method, record count, raw and packed length, CRC32
+//   payload             'count' records serialized back to back with Serialize
+//
+// Memory use is bounded by one chunk. RecordReader reads the chunks back one by one and
+// offers the records as a range. Every chunk is flushed as soon as it is complete, and a
+// truncated chunk at the end of the file is simply not consumed yet, so a reader can
+// follow a file that is still being written by calling Refresh and reading on.
+
+enum {
+    RECORD_RAW,
+    RECORD_LZ4,
+    RECORD_ZSTD,
+};
+
+static const dword record_chunk_magic = 0x4B484352; // "RCHK"
+
+struct RecordChunkHeader {
+    dword  magic;
+    byte   method;
+    byte   reserved[3];
+    int    count;
+    int    raw_len;
+    int    packed_len;
+    dword  crc;            // of the payload as stored
+};
+
+static_assert(sizeof(RecordChunkHeader) == 24, "unexpected padding in RecordChunkHeader");
+
+class RecordWriter : NoCopy {
+    FileOut      out;
+    StringStream chunk;
+    int          count = 0;
+    int          method = RECORD_LZ4;
+    int          chunk_size = 256 * 1024;
+
+public:
+    bool Open(const char *path, int method_ = RECORD_LZ4, int chunk_size_ = 256 * 1024) {
+        method = method_;
+        chunk_size = chunk_size_;
+        count = 0;
+        chunk.Create();
+        return out.Open(path);
+    }
+
+    // Like StoreToFile, x is passed by reference because Serialize is not const
+    template <class T>
+    void Put(T& x) {
+        chunk % x;
+        count++;
+        if(chunk.GetSize() >= chunk_size)
+            Flush();
+    }
+
+    // Writes the pending records as one chunk and makes it visible to readers
+    void Flush() {
+        if(!count)
+            return;
+        String raw = chunk.GetResult();
+        chunk.Create();
+        String packed = method == RECORD_LZ4  ? LZ4Compress(raw) :
+                        method == RECORD_ZSTD ? ZstdCompress(raw) : raw;
+        RecordChunkHeader h;
+        h.magic = record_chunk_magic;
+        h.method = method;
+        memset(h.reserved, 0, sizeof(h.reserved));
+        h.count = count;
+        h.raw_len = raw.GetCount();
+        h.packed_len = packed.GetCount();
+        h.crc = CRC32(packed);
+        out.Put(&h, sizeof(h));
+        out.Put(packed);
+        out.Flush();
+        count = 0;
+    }
+
+    bool Close() {
+        Flush();
+        out.Close();
+        return !out.IsError();
+    }
+
+    bool IsError() const { return out.IsError(); }
+
+    ~RecordWriter() { if(out.IsOpen()) Close(); }
+};
+
+class RecordReader : NoCopy {
+    String       path;
+    FileIn       in;
+    int64        pos = 0;      // start of the next unread chunk
+    StringStream chunk;
+    int          left = 0;     // records left in the current chunk
+    bool         error = false;
+
+    bool ReadChunk() {
+        RecordChunkHeader h;
+        if(error || in.GetSize() - pos < (int64)sizeof(h))
+            return false;
+        in.Seek(pos);
+        in.Get(&h, sizeof(h));
+        if(h.magic != record_chunk_magic || h.method > RECORD_ZSTD || h.count < 0 ||
+           h.raw_len < 0 || h.packed_len < 0) {
+            error = true;
+            return false;
+        }
+        if(in.GetSize() - pos - (int64)sizeof(h) < h.packed_len)
+            return false; // the writer has not finished this chunk yet
+        String packed = in.Get(h.packed_len);
+        if(packed.GetCount() != h.packed_len || CRC32(packed) != h.crc) {
+            error = true;
+            return false;
+        }
+        String raw = h.method == RECORD_LZ4  ? LZ4Decompress(packed) :
+                     h.method == RECORD_ZSTD ? ZstdDecompress(packed) : packed;
+        if(raw.GetCount() != h.raw_len) {
+            error = true;
+            return false;
+        }
+        chunk.Open(raw);
+        left = h.count;
+        pos += sizeof(h) + h.packed_len;
+        return true;
+    }
+
+public:
+    bool Open(const char *path_) {
+        path = path_;
+        pos = 0;
+        left = 0;
+        error = false;
+        return in.Open(path);
+    }
+
+    // Reads the next record; false at the end of the data written so far or on error
+    template <class T>
+    bool Get(T& x) {
+        while(left == 0)
+            if(!ReadChunk())
+                return false;
+        chunk % x;
+        left--;
+        if(chunk.IsError()) {
+            error = true;
+            return false;
+        }
+        return true;
+    }
+
+    // Reopens the file to see chunks appended since it was opened
+    bool Refresh() {
+        in.Close();
+        return in.Open(path);
+    }
+
+    bool IsError() const { return error; }
+
+    // for(const T& x : reader.Records<T>()) ...
+    template <class T>
+    class Range {
+        RecordReader& reader;
+
+    public:
+        class Iterator {
+            RecordReader *reader;
+            T             value;
+
+        public:
+            Iterator(RecordReader *r) : reader(r) { if(reader && !reader->Get(value)) reader = nullptr; }
+            const T& operator*() const             { return value; }
+            const T *operator->() const            { return &value; }
+            Iterator& operator++()                 { if(!reader->Get(value)) reader = nullptr; return *this; }
+            bool operator!=(const Iterator& b) const { return reader != b.reader; }
+        };
+
+        Iterator begin() const { return Iterator(&reader); }
+        Iterator end() const   { return Iterator(nullptr); }
+
+        Range(RecordReader& r) : reader(r) {}
+    };
+
+    template <class T>
+    Range<T> Records() { return Range<T>(*this); }
+};
+
+// Same as MySerializationExample.cpp
+struct MySerializableObject : Moveable<MySerializableObject> {
+    String name;
+    int    value;
+
+    MySerializableObject() : value(0) {}
+    MySerializableObject(String n, int v) : name(n), value(v) {}
+
+    void Serialize(Stream& s) {
+        s % name % value;
+    }
+
+    String ToString() const {
+        return Sprintf("Name: %s, Value: %d", name, value);
+    }
+};
+
+static MySerializableObject MakeObject(int i)
+{
+    return MySerializableObject(Format("Export record %d", i), i);
+}
+
+CONSOLE_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    int count = 2000000;
+    String path = GetTempFileName();
+
+    // Whole collection in memory, as with StoreToFile
+    {
+        int mem0 = MemoryUsedKb();
+        int64 t0 = usecs();
+        Vector<MySerializableObject> data;
+        for(int i = 0; i < count; i++)
+            data.Add(MakeObject(i));
+        int mem = MemoryUsedKb() - mem0;
+        StoreToFile(data, path);
+        RLOG(Format("StoreToFile:        %7.0f ms, %6d KB file, heap +%d KB",
+                    usecs(t0) / 1000.0, (int)(GetFileLength(path) / 1024), mem));
+    }
+
+    // Streamed, one chunk in memory at a time
+    struct Method { const char *name; int method; };
+    Method methods[] = { { "raw", RECORD_RAW }, { "LZ4", RECORD_LZ4 }, { "zstd", RECORD_ZSTD } };
+    for(const Method& m : methods) {
+        int mem0 = MemoryUsedKb();
+        int peak = 0;
+        int64 t0 = usecs();
+        RecordWriter w;
+        w.Open(path, m.method);
+        for(int i = 0; i < count; i++) {
+            MySerializableObject o = MakeObject(i);
+            w.Put(o);
+            if((i & 0xffff) == 0)
+                peak = max(peak, MemoryUsedKb() - mem0);
+        }
+        w.Close();
+        double t_write = usecs(t0) / 1000.0;
+
+        t0 = usecs();
+        RecordReader r;
+        r.Open(path);
+        int64 check = 0;
+        int n = 0;
+        for(const MySerializableObject& o : r.Records<MySerializableObject>()) {
+            check += o.value;
+            n++;
+        }
+        RLOG(Format("RecordWriter %-5s: %7.0f ms, %6d KB file, heap +%d KB, read %d records in %.0f ms%s",
+                    m.name, t_write, (int)(GetFileLength(path) / 1024), peak, n, usecs(t0) / 1000.0,
+                    r.IsError() ? ", read error" : ""));
+        ASSERT(n == count && check == (int64)count * (count - 1) / 2);
+    }
+
+    // Reader follows the file while the exporter is still writing it
+    {
+        DeleteFile(path); // the reader must not see the previous run's chunks
+        Atomic done;
+        done = 0;
+        int64 t0 = usecs();
+        Thread exporter;
+        exporter.Run([&] {
+            RecordWriter w;
+            w.Open(path, RECORD_LZ4);
+            for(int i = 0; i < count; i++) {
+                MySerializableObject o = MakeObject(i);
+                w.Put(o);
+            }
+            w.Close();
+            done = 1;
+        });
+
+        RecordReader r;
+        while(!r.Open(path))
+            Sleep(1);
+        int n = 0;
+        int64 t_first = -1;
+        MySerializableObject o;
+        for(;;) {
+            bool finished = done; // everything is on disk once the writer is done
+            r.Refresh();
+            while(r.Get(o)) {
+                if(t_first < 0)
+                    t_first = usecs(t0);
+                n++;
+            }
+            if(finished || r.IsError())
+                break;
+            Sleep(5);
+        }
+        exporter.Wait();
+        RLOG(Format("Tailing reader: first record after %.1f ms, %d records in %.0f ms total",
+                    t_first / 1000.0, n, usecs(t0) / 1000.0));
+        DUMP(o);
+    }
+
+    DeleteFile(path);
+}
@@ -0,0 +1,225 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Tile grid with minimal relayout and partial repaint (compare with the "Responsive Tile
+// Grid" in UppApplicationSessionGuide.md).
+//
+// The guide's Window::Layout stretches the tiles to the window, so every resize step
+// calls SetRect on every tile and every tile repaints completely. TileGrid uses a fixed
+// cell size and reflows the tiles into as many columns as fit. The column and row
+// positions are kept in tables that are rebuilt only when the column count or the number
+// of tiles changes, and SetRect is called only for tiles whose rectangle actually
+// changed. While resizing within the same column count no tile moves, so only the newly
+// exposed area gets painted.
+//
+// Rows that do not fit are reached with a vertical ScrollBar. Only the tiles of the
+// visible rows are positioned and shown; tiles that scroll out are hidden, so neither
+// Layout nor painting touches them, however many tiles the grid holds.
+//
+// Tiles repaint only what was invalidated: a value update refreshes just the value
+// rectangle, and Paint checks Draw::IsPainting before drawing each part.
+//
+// The overlay in the bottom right corner shows the time from Layout to the end of paint
+// for recent frames, how many tiles were painted and how many SetRect calls were skipped.
+
+class Tile : public Ctrl {
+    String title;
+    int    value = 0;
+
+    enum { HEADER = 16 };
+
+    Rect ValueRect() const { Size sz = GetSize(); return Rect(4, HEADER + 2, sz.cx - 4, sz.cy - 4); }
+
+public:
+    static int painted; // tiles painted since the overlay last looked
+
+    virtual void Paint(Draw& w) override {
+        painted++;
+        Size sz = GetSize();
+        if(w.IsPainting(0, 0, sz.cx, HEADER)) {
+            w.DrawRect(0, 0, sz.cx, HEADER, Color(220, 225, 235));
+            w.DrawText(4, 1, title, StdFont().Height(11), SColorText());
+        }
+        Rect v = ValueRect();
+        if(w.IsPainting(Rect(0, HEADER, sz.cx, sz.cy))) {
+            w.DrawRect(0, HEADER, sz.cx, sz.cy - HEADER, White());
+            String s = AsString(value);
+            Font font = StdFont().Height(max(10, v.GetHeight() / 2)).Bold();
+            Size tsz = GetTextSize(s, font);
+            w.DrawText(v.left + (v.GetWidth() - tsz.cx) / 2, v.top + (v.GetHeight() - tsz.cy) / 2,
+                       s, font, value % 10 ? SColorText() : LtRed());
+        }
+    }
+
+    void SetValue(int v) {
+        if(v == value)
+            return;
+        value = v;
+        Refresh(ValueRect());
+    }
+
+    Tile& Title(const String& t) { title = t; Refresh(0, 0, GetSize().cx, HEADER); return *this; }
+};
+
+int Tile::painted;
+
+class TileGrid : public Ctrl {
+    Vector<Ctrl *> tiles;
+    Size           cell = Size(64, 44);
+    int            gap = 6;
+    int            columns = 0;      // layout the tables were built for
+    int            laid_count = 0;
+    Vector<int>    colx, rowy;       // left / top edge of every column / row
+    ScrollBar      sb;
+    int            shown_first = 0;  // tiles [shown_first, shown_end) are visible
+    int            shown_end = 0;
+
+    void BuildTables(int cols) {
+        columns = cols;
+        laid_count = tiles.GetCount();
+        int rows = (laid_count + cols - 1) / cols;
+        colx.SetCount(cols);
+        for(int c = 0; c < cols; c++)
+            colx[c] = gap + c * (cell.cx + gap);
+        rowy.SetCount(rows);
+        for(int r = 0; r < rows; r++)
+            rowy[r] = gap + r * (cell.cy + gap);
+    }
+
+public:
+    int     moved = 0;               // statistics of the last Layout
+    int     skipped = 0;
+    int64   layout_time = 0;
+    Event<> WhenLayout;
+
+    virtual void Layout() override {
+        layout_time = usecs();
+        Size sz = GetSize();
+        int cols = max(1, (sz.cx - gap) / (cell.cx + gap));
+        if(cols != columns || laid_count != tiles.GetCount())
+            BuildTables(cols);
+        int pitch = cell.cy + gap;
+        sb.SetPage(sz.cy);
+        sb.SetTotal(gap + rowy.GetCount() * pitch);
+        sb.SetLine(pitch);
+        int y0 = sb.Get();
+        int first = min(tiles.GetCount(), max(0, (y0 - gap) / pitch) * columns);
+        int end = min(tiles.GetCount(), ((y0 + sz.cy) / pitch + 1) * columns);
+        for(int i = shown_first; i < min(shown_end, tiles.GetCount()); i++)
+            if(i < first || i >= end)
+                tiles[i]->Hide();
+        shown_first = first;
+        shown_end = end;
+        moved = skipped = 0;
+        for(int i = first; i < end; i++) {
+            Rect r = RectC(colx[i % columns], rowy[i / columns] - y0, cell.cx, cell.cy);
+            if(tiles[i]->GetRect() == r && tiles[i]->IsShown())
+                skipped++;
+            else {
+                tiles[i]->SetRect(r);
+                tiles[i]->Show();
+                moved++;
+            }
+        }
+        WhenLayout();
+    }
+
+    virtual void MouseWheel(Point, int zdelta, dword) override {
+        sb.Wheel(zdelta);
+    }
+
+    virtual void Paint(Draw& w) override {
+        w.DrawRect(GetSize(), SColorFace());
+    }
+
+    void AddTile(Ctrl& c) {
+        tiles.Add(&c);
+        c.Hide(); // Layout shows it if its row is visible
+        Add(c);
+        Layout();
+    }
+
+    TileGrid& CellSize(Size sz) { cell = sz; columns = 0; Layout(); return *this; }
+    TileGrid& Gap(int g)        { gap = g; columns = 0; Layout(); return *this; }
+
+    TileGrid() {
+        AddFrame(sb);
+        sb.WhenScroll = [=] { Layout(); };
+    }
+};
+
+// Frame statistics, painted last so the time includes the tiles painted in the same pass
+class FrameTimeOverlay : public Ctrl {
+    Vector<int> frame_us;            // ring of recent Layout-to-paint times
+    int         next = 0;
+    int         tiles = 0;
+
+public:
+    TileGrid *grid = nullptr;
+
+    void NewFrame() { Refresh(); }
+
+    virtual void Paint(Draw& w) override {
+        if(grid && grid->layout_time) {
+            int us = int(usecs() - grid->layout_time);
+            grid->layout_time = 0;
+            if(frame_us.GetCount() < 120)
+                frame_us.Add(us);
+            else
+                frame_us[next++ % 120] = us;
+            tiles = Tile::painted;
+        }
+        Tile::painted = 0;
+
+        Size sz = GetSize();
+        w.DrawRect(sz, Blend(Black(), SColorPaper(), 40));
+        Vector<int> s = clone(frame_us);
+        Sort(s);
+        auto pct = [&](int p) { return s.GetCount() ? s[min(s.GetCount() - 1, s.GetCount() * p / 100)] / 1000.0 : 0.0; };
+        Font font = Monospace(11);
+        int y = 4;
+        auto line = [&](const String& t) { w.DrawText(6, y, t, font, White()); y += font.GetCy(); };
+        line(Format("frame p50 %.2f ms  p99 %.2f ms", pct(50), pct(99)));
+        line(Format("max %.2f ms over %d frames", s.GetCount() ? s.Top() / 1000.0 : 0.0, s.GetCount()));
+        if(grid)
+            line(Format("tiles painted %d, SetRect %d, skipped %d", tiles, grid->moved, grid->skipped));
+    }
+};
+
+struct MyTileGridWindow : TopWindow {
+    typedef MyTileGridWindow CLASSNAME;
+
+    TileGrid         grid;
+    Array<Tile>      tiles;
+    FrameTimeOverlay overlay;
+
+    void Tick() {
+        for(int i = 0; i < 5; i++) // a few live values change, the rest stays as is
+            tiles[Random(tiles.GetCount())].SetValue(Random(1000));
+    }
+
+    MyTileGridWindow(int count = 500) {
+        Title("Tile Grid Example");
+        SetRect(0, 0, 1400, 900);
+        Sizeable().Zoomable();
+
+        grid.NoWantFocus();
+        Add(grid.SizePos());
+        for(int i = 0; i < count; i++) {
+            Tile& t = tiles.Add();
+            t.Title(Format("Sensor %d", i)).SetValue(Random(1000));
+            grid.AddTile(t);
+        }
+
+        overlay.grid = &grid;
+        grid.WhenLayout = [=] { overlay.NewFrame(); };
+        Add(overlay.RightPos(8, 300).BottomPos(8, 56));
+
+        SetTimeCallback(-50, THISBACK(Tick));
+    }
+};
+
+GUI_APP_MAIN {
+    MyTileGridWindow().Run();
+}
@@ -0,0 +1,286 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Compile-time typed Display/Convert for ArrayCtrl columns (compare with
+// MyColorValueDisplay / MyColorValueConvert in MyColorValueExample.cpp).
+//
+// The registered-type path stores every cell as a Value, and every paint goes through the
+// virtual Display::Paint, a q.Is<MyColorValue>() type check and Get before anything is
+// drawn; Convert works the same way. Here the per-type code lives in ColumnTraits<T>, a
+// struct of static inline functions (Paint, Format, Scan), specialised per type.
+//
+// Two opt-in bindings use the same traits:
+//
+//  - TypedDisplay<T> / TypedConvert<T> are ordinary Display / Convert classes for
+//    Value-based columns and RegisterValueType; they keep the Value path working and
+//    only gain the inlined drawing code
+//  - TypedColumn<T> owns a Vector<T> and adds a row-number column to an ArrayCtrl in
+//    virtual mode. The ArrayCtrl passes the row index; the cell display indexes the
+//    Vector<T> and calls the traits directly, so there is no boxing, no type id check and
+//    no virtual call below the one ArrayCtrl makes per cell
+//
+// Run with "--bench" to compare paint throughput of the three paths, both cell by cell
+// and for whole ArrayCtrl frames drawn into an ImageDraw.
+
+struct MyColorValue : Moveable<MyColorValue> {
+    Color  colorVal;
+    String name;
+
+    MyColorValue() : colorVal(Black()) {}
+    MyColorValue(Color c, String n) : colorVal(c), name(n) {}
+};
+
+template <class T>
+struct ColumnTraits;
+
+template <>
+struct ColumnTraits<MyColorValue> {
+    static void Paint(Draw& w, const Rect& r, const MyColorValue& x, Color ink, Color paper, dword) {
+        w.DrawRect(r, paper);
+        Rect colorBox = r;
+        colorBox.right = r.left + r.GetHeight();
+        w.DrawRect(colorBox, x.colorVal);
+        Font font = StdFont();
+        w.DrawText(colorBox.right + 4, r.top + (r.GetHeight() - font.GetCy()) / 2, x.name, font, ink);
+    }
+
+    static String Format(const MyColorValue& x) {
+        return Sprintf("%s (#%02X%02X%02X)", ~x.name, x.colorVal.GetR(), x.colorVal.GetG(), x.colorVal.GetB());
+    }
+
+    // "Name (#RRGGBB)"; the color is in the last brackets, so names may contain '('
+    static bool Scan(const String& s, MyColorValue& x) {
+        int o = s.ReverseFind('(');
+        int c = s.Find(')', o + 1);
+        if(o < 0 || c < 0 || c - o != 8 || s[o + 1] != '#')
+            return false;
+        dword rgb = 0;
+        for(int i = o + 2; i < c; i++) {
+            int d = ctoi(s[i]);
+            if(d < 0 || d > 15)
+                return false;
+            rgb = (rgb << 4) | d;
+        }
+        x.name = TrimBoth(s.Left(o));
+        x.colorVal = Color(byte(rgb >> 16), byte(rgb >> 8), byte(rgb));
+        return true;
+    }
+};
+
+template <>
+struct ColumnTraits<int> {
+    static void Paint(Draw& w, const Rect& r, int x, Color ink, Color paper, dword) {
+        w.DrawRect(r, paper);
+        char h[16];
+        int n = sprintf(h, "%d", x);
+        Font font = StdFont();
+        w.DrawText(r.left + 2, r.top + (r.GetHeight() - font.GetCy()) / 2, h, font, ink, n);
+    }
+
+    static String Format(int x)                { return AsString(x); }
+    static bool   Scan(const String& s, int& x) { x = ScanInt(s); return !IsNull(x); }
+};
+
+// Value-based Display using the traits, for RegisterValueType or Value columns
+template <class T, class Traits = ColumnTraits<T>>
+class TypedDisplay : public Display {
+public:
+    virtual void Paint(Draw& w, const Rect& r, const Value& q,
+                       Color ink, Color paper, dword style) const {
+        if(q.Is<T>())
+            Traits::Paint(w, r, q.To<T>(), ink, paper, style);
+        else
+            StdDisplay().Paint(w, r, q, ink, paper, style);
+    }
+};
+
+template <class T, class Traits = ColumnTraits<T>>
+class TypedConvert : public Convert {
+public:
+    virtual Value Format(const Value& q) const {
+        return q.Is<T>() ? Value(Traits::Format(q.To<T>())) : q;
+    }
+
+    virtual Value Scan(const Value& q) const {
+        T x;
+        return IsString(q) && Traits::Scan(q, x) ? RawToValue(x) : ErrorValue();
+    }
+};
+
+// A column of T values shown by an ArrayCtrl in virtual mode
+template <class T, class Traits = ColumnTraits<T>>
+class TypedColumn : NoCopy {
+    struct CellDisplay : Display {
+        const TypedColumn *column = nullptr;
+
+        virtual void Paint(Draw& w, const Rect& r, const Value& q,
+                           Color ink, Color paper, dword style) const {
+            if(IsNull(q))
+                w.DrawRect(r, paper);
+            else
+                Traits::Paint(w, r, column->data[(int)q], ink, paper, style);
+        }
+    };
+
+    Vector<T>   data;
+    CellDisplay display;
+
+public:
+    // The ArrayCtrl's virtual count has to follow the column, see SetVirtualCount
+    ArrayCtrl::Column& AddTo(ArrayCtrl& list, const char *title, int width) {
+        return list.AddRowNumColumn(title, width).SetDisplay(display);
+    }
+
+    T&        Add(const T& x)               { return data.Add(x); }
+    T&        Add(T&& x)                    { return data.Add(pick(x)); }
+    void      Set(int i, const T& x)        { data[i] = x; }
+    const T&  operator[](int i) const       { return data[i]; }
+    int       GetCount() const              { return data.GetCount(); }
+    void      Reserve(int n)                { data.Reserve(n); }
+    void      Clear()                       { data.Clear(); }
+
+    // The display ArrayCtrl calls with the row index
+    const Display& GetDisplay() const       { return display; }
+
+    String    Format(int i) const           { return Traits::Format(data[i]); }
+    bool      Scan(int i, const String& s)  { T x; if(!Traits::Scan(s, x)) return false; data[i] = pick(x); return true; }
+
+    TypedColumn()                           { display.column = this; }
+};
+
+static MyColorValue MakeSwatch(int i)
+{
+    static const char *names[] = { "Red", "Green", "Blue", "Orange", "Teal", "Violet" };
+    return MyColorValue(Color(37 * i % 256, 91 * i % 256, 173 * i % 256),
+                        Format("%s %d", names[i % 6], i));
+}
+
+// The original display, for the benchmark
+class MyColorValueDisplay : public Display {
+public:
+    virtual void Paint(Draw& w, const Rect& r, const Value& q,
+                       Color ink, Color paper, dword style) const {
+        if(q.Is<MyColorValue>()) {
+            const MyColorValue& mcv = q.Get<MyColorValue>();
+            w.DrawRect(r, paper);
+            Rect colorBox = r;
+            colorBox.right = r.left + r.GetHeight();
+            w.DrawRect(colorBox, mcv.colorVal);
+            Font font = StdFont();
+            w.DrawText(colorBox.right + 4, r.top + (r.GetHeight() - font.GetCy()) / 2, mcv.name, font, ink);
+        }
+        else
+            StdDisplay().Paint(w, r, q, ink, paper, style);
+    }
+};
+
+struct MyTypedColumnWindow : TopWindow {
+    ArrayCtrl                 list;
+    TypedColumn<int>          id;
+    TypedColumn<MyColorValue> swatch;
+    EditString                edit;
+    Label                     status;
+
+    void Load(int rows) {
+        id.Clear();
+        swatch.Clear();
+        id.Reserve(rows);
+        swatch.Reserve(rows);
+        for(int i = 0; i < rows; i++) {
+            id.Add(i);
+            swatch.Add(MakeSwatch(i));
+        }
+        list.SetVirtualCount(rows);
+    }
+
+    MyTypedColumnWindow() {
+        Title("Typed Column Example");
+        SetRect(0, 0, 400, 600);
+        Sizeable().Zoomable();
+
+        id.AddTo(list, "ID", 60);
+        swatch.AddTo(list, "Swatch", 240);
+        Load(100000);
+
+        // Scan through the traits: edit the selected swatch as "Name (#RRGGBB)"
+        list.WhenCursor = [=] {
+            if(list.IsCursor())
+                edit <<= swatch.Format(list.GetCursor());
+        };
+        edit.WhenEnter = [=] {
+            bool ok = list.IsCursor() && swatch.Scan(list.GetCursor(), ~edit);
+            status.SetLabel(ok ? "Updated" : "Expected 'Name (#RRGGBB)'");
+            list.Refresh();
+        };
+
+        Add(list.VSizePos(0, 48).HSizePos());
+        Add(edit.BottomPos(24, 24).HSizePos(4, 4));
+        Add(status.BottomPos(0, 24).HSizePos(4, 4));
+    }
+};
+
+// Paints 'frames' frames of 60 cells into an ImageDraw; 'cell' returns the Value for a row
+template <class Cell>
+static double CellFps(const Display& d, int rows, int frames, Cell cell)
+{
+    int row_cy = StdFont().GetCy() + 4;
+    Size sz(300, 60 * row_cy);
+    ImageDraw iw(sz);
+    int64 t0 = usecs();
+    for(int f = 0; f < frames; f++) {
+        int first = f * 3 % (rows - 60);
+        for(int i = 0; i < 60; i++)
+            d.Paint(iw, RectC(0, i * row_cy, sz.cx, row_cy), cell(first + i), SColorText(), SColorPaper(), 0);
+    }
+    return frames / (usecs(t0) / 1e6);
+}
+
+// Draws the whole ArrayCtrl 'frames' times, scrolling by 3 rows per frame
+static double ListFps(ArrayCtrl& list, int frames)
+{
+    list.SetRect(0, 0, 300, 60 * list.GetLineCy() + 24);
+    ImageDraw iw(list.GetSize());
+    int64 t0 = usecs();
+    for(int f = 0; f < frames; f++) {
+        list.ScrollInto(f * 3 % (list.GetCount() - 60));
+        list.DrawCtrl(iw);
+    }
+    return frames / (usecs(t0) / 1e6);
+}
+
+GUI_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    if(FindIndex(CommandLine(), "--bench") >= 0) {
+        int rows = 10000;
+        Vector<Value> values;
+        for(int i = 0; i < rows; i++)
+            values.Add(RawToValue(MakeSwatch(i)));
+        TypedColumn<MyColorValue> column;
+        for(int i = 0; i < rows; i++)
+            column.Add(MakeSwatch(i));
+        MyColorValueDisplay original;
+        TypedDisplay<MyColorValue> typed;
+        double fps_original = CellFps(original, rows, 2000, [&](int i) -> const Value& { return values[i]; });
+        double fps_typed = CellFps(typed, rows, 2000, [&](int i) -> const Value& { return values[i]; });
+        double fps_column = CellFps(column.GetDisplay(), rows, 2000, [&](int i) { return Value(i); });
+        RLOG(Format("Cells, 60 per frame:  Value + MyColorValueDisplay %7.0f fps, TypedDisplay %7.0f fps, "
+                    "TypedColumn %7.0f fps", fps_original, fps_typed, fps_column));
+
+        ArrayCtrl value_list;
+        value_list.AddColumn("ID", 60);
+        value_list.AddColumn("Swatch", 240).SetDisplay(Single<MyColorValueDisplay>());
+        for(int i = 0; i < rows; i++)
+            value_list.Add(i, values[i]);
+        MyTypedColumnWindow typed_win;
+        typed_win.Load(rows);
+        double fps_value_list = ListFps(value_list, 500);
+        double fps_typed_list = ListFps(typed_win.list, 500);
+        RLOG(Format("Whole ArrayCtrl:      Value cells %7.0f fps, typed columns %7.0f fps, %.2fx",
+                    fps_value_list, fps_typed_list, fps_typed_list / fps_value_list));
+        return;
+    }
+
+    MyTypedColumnWindow().Run();
+}
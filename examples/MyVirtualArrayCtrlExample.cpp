@@ -0,0 +1,192 @@
+#include <CtrlLib/CtrlLib.h>
+
+using namespace Upp;
+
+// Virtual (owner-data) variant of MyArrayCtrlExample.cpp.
+//
+// The ArrayCtrl stores no cells at all: it only knows the row count (SetVirtualCount).
+// Both columns are row-number columns, so the value ArrayCtrl hands to a column's Convert
+// is just the row index. The Convert asks a row provider for that row through a small
+// block cache, which means only painted rows (plus the rest of their block) are ever
+// produced and memory is bounded by the cache size, not by the dataset.
+//
+// Run with "--bench" to compare Add() population against virtual mode at 1M and 10M rows.
+
+// Fills 'row' with the cell values of row 'i'
+typedef Function<void (int i, Vector<Value>& row)> RowProvider;
+
+// Keeps the last few blocks of rows produced by the provider. Rows are fetched a whole
+// block at a time, which is the read-ahead: scrolling line by line or painting the next
+// screen mostly hits a block that is already filled.
+class VirtualRowCache {
+    struct Block {
+        int                   first = -1; // first row of the block, -1 = unused
+        int64                 stamp = 0;  // last use, for LRU eviction
+        Vector<Vector<Value>> rows;
+    };
+
+    RowProvider  provider;
+    Array<Block> blocks;
+    int          block_rows;
+    int          count = 0;
+    int          last = -1;   // index of the last block hit, fast path for sequential paint
+    int64        clock = 0;
+    int          fetched = 0; // rows produced by the provider so far (statistics)
+
+    Block& Fetch(int first) {
+        int lru = 0;
+        for(int i = 0; i < blocks.GetCount(); i++) {
+            if(blocks[i].first == first) {
+                last = i;
+                return blocks[i];
+            }
+            if(blocks[i].stamp < blocks[lru].stamp)
+                lru = i;
+        }
+        Block& b = blocks[lru];
+        b.first = first;
+        b.rows.SetCount(min(block_rows, count - first));
+        for(int i = 0; i < b.rows.GetCount(); i++) {
+            b.rows[i].Clear();
+            provider(first + i, b.rows[i]);
+        }
+        fetched += b.rows.GetCount();
+        last = lru;
+        return b;
+    }
+
+public:
+    // Number of rows, must match the ArrayCtrl virtual count
+    void  SetCount(int n)                    { count = n; Invalidate(); }
+    void  SetProvider(RowProvider p)         { provider = pick(p); Invalidate(); }
+    void  Invalidate()                       { for(Block& b : blocks) b.first = -1; last = -1; }
+    int   GetFetchedCount() const            { return fetched; }
+    int   GetMemoryRows() const              { return blocks.GetCount() * block_rows; }
+
+    Value Get(int row, int column) {
+        if(row < 0 || row >= count)
+            return Value();
+        int first = row - row % block_rows;
+        Block& b = last >= 0 && blocks[last].first == first ? blocks[last] : Fetch(first);
+        b.stamp = ++clock;
+        const Vector<Value>& r = b.rows[row - first];
+        return column < r.GetCount() ? r[column] : Value();
+    }
+
+    VirtualRowCache(int block_rows = 64, int max_blocks = 8) : block_rows(block_rows) {
+        blocks.SetCount(max_blocks);
+    }
+};
+
+// Converts the row number ArrayCtrl passes for a row-number column into the cell value
+struct VirtualColumnConvert : Convert {
+    VirtualRowCache *cache = nullptr;
+    int              column = 0;
+
+    virtual Value Format(const Value& q) const {
+        return IsNull(q) ? Value() : cache->Get((int)q, column);
+    }
+};
+
+// Synthetic row source standing in for a multi-million-row trade log
+static String TradeName(int i) {
+    static const char *names[] = { "Alice", "Bob", "Charlie", "David" };
+    return Format("%s #%d", names[i % 4], i);
+}
+
+static void MakeTradeRow(int i, Vector<Value>& row) {
+    row << i + 1 << TradeName(i);
+}
+
+// Main window, same columns as MyArrayCtrlWindow but with virtual rows
+class MyVirtualArrayCtrlWindow : public TopWindow {
+public:
+    typedef MyVirtualArrayCtrlWindow CLASSNAME;
+
+    ArrayCtrl            dataList;
+    VirtualRowCache      cache;
+    VirtualColumnConvert idConvert, nameConvert;
+
+    // Construction is O(1) in 'rows': nothing is produced until the list is painted
+    void SetDataset(int rows, RowProvider provider) {
+        cache.SetProvider(pick(provider));
+        cache.SetCount(rows);
+        dataList.SetVirtualCount(rows);
+    }
+
+    MyVirtualArrayCtrlWindow() {
+        Title("Virtual ArrayCtrl Example");
+        SetRect(0, 0, 400, 300);
+        Sizeable().Zoomable();
+
+        idConvert.cache = nameConvert.cache = &cache;
+        idConvert.column = 0;
+        nameConvert.column = 1;
+
+        dataList.AddRowNumColumn("ID", 50).SetConvert(idConvert);
+        dataList.AddRowNumColumn("Name", 150).SetConvert(nameConvert).HeaderTab().AlignCenter();
+        dataList.MultiSelect();
+        dataList.SetLineCy(20);
+
+        SetDataset(10000000, [](int i, Vector<Value>& row) { MakeTradeRow(i, row); });
+
+        Add(dataList.SizePos());
+    }
+};
+
+// Benchmark: Add() population versus virtual mode
+static void BenchmarkPopulation(int rows)
+{
+    RLOG("---- " << rows << " rows");
+    {
+        int mem0 = MemoryUsedKb();
+        int64 t0 = usecs();
+        ArrayCtrl list;
+        list.AddColumn("ID", 50);
+        list.AddColumn("Name", 150);
+        for(int i = 0; i < rows; i++)
+            list.Add(i + 1, TradeName(i));
+        int64 t = usecs(t0);
+        int mem = MemoryUsedKb() - mem0;
+        RLOG(Format("Add():   %8.1f ms, %8d KB (%.1f bytes/row)",
+                    t / 1000.0, mem, 1024.0 * mem / rows));
+    }
+    {
+        int mem0 = MemoryUsedKb();
+        int64 t0 = usecs();
+        ArrayCtrl list;
+        VirtualRowCache cache;
+        VirtualColumnConvert idConvert, nameConvert;
+        idConvert.cache = nameConvert.cache = &cache;
+        nameConvert.column = 1;
+        list.AddRowNumColumn("ID", 50).SetConvert(idConvert);
+        list.AddRowNumColumn("Name", 150).SetConvert(nameConvert);
+        cache.SetProvider([](int i, Vector<Value>& row) { MakeTradeRow(i, row); });
+        cache.SetCount(rows);
+        list.SetVirtualCount(rows);
+        int64 t_setup = usecs(t0);
+
+        // Simulate painting one 60 row viewport in the middle of the dataset
+        t0 = usecs();
+        int64 chars = 0;
+        for(int i = rows / 2; i < rows / 2 + 60; i++)
+            chars += AsString(idConvert.Format(i)).GetCount() + nameConvert.Format(i).ToString().GetCount();
+        int64 t_view = usecs(t0);
+        int mem = MemoryUsedKb() - mem0;
+        RLOG(Format("Virtual: %8.3f ms setup, %.3f ms first viewport, %d KB total, %d rows fetched (%d chars)",
+                    t_setup / 1000.0, t_view / 1000.0, mem, cache.GetFetchedCount(), chars));
+    }
+}
+
+// Main function for the GUI application
+GUI_APP_MAIN {
+    StdLogSetup(LOG_COUT|LOG_FILE);
+
+    if(FindIndex(CommandLine(), "--bench") >= 0) {
+        BenchmarkPopulation(1000000);
+        BenchmarkPopulation(10000000);
+        return;
+    }
+
+    MyVirtualArrayCtrlWindow().Run();
+}
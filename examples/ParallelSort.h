@@ -0,0 +1,399 @@
+#ifndef _examples_ParallelSort_h_
+#define _examples_ParallelSort_h_
+
+#include <Core/Core.h>
+
+#ifdef CPU_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace Upp;
+
+// Parallel sorting and SIMD search over Vector / SubRange (compare with Sort, FindIndex
+// and SubRange in the guide's "Ranges and Algorithms" section).
+//
+// All three take a range the way Sort and FindIndex do, so Vector, Array and
+// SubRange(data, pos, count) all work:
+//
+//  - ParallelSort(r[, less]) is a merge sort on CoWork: the range is cut into one run per
+//    thread, the runs are sorted with Sort in parallel, then merged pairwise. Every merge
+//    is split into equal output pieces at co-rank positions found by binary search, so
+//    the last rounds, which merge just two or four huge runs, still keep all threads
+//    busy. It needs a buffer of the range's size and, like Sort, is not stable
+//  - RadixSort(r[, key]) is a stable LSD radix sort, 8 bits per pass, for integer and
+//    floating point elements or any element with a fixed-width unsigned key (dword or
+//    uint64, from 'key'). Histograms and scatter run per chunk in parallel, and a pass
+//    is skipped when all keys share that byte
+//  - FastFindIndex(r, value[, from]) is FindIndex with SSE2 compares for arithmetic
+//    elements stored contiguously (Vector, SubRange of a Vector); it finds what FindIndex
+//    finds for any arithmetic needle. Other ranges and types, and needles whose common type
+//    with the element would merge element values, fall back to the plain loop
+//
+// Ranges smaller than PARALLEL_SORT_MIN are sorted by one thread. The thread count
+// follows CoWork::GetPoolSize() + 1, as the calling thread takes part.
+
+enum { PARALLEL_SORT_MIN = 65536 }; // elements per run, below that threads do not pay off
+
+// Number of elements of the merged output [0, k) that come from 'a', ties go to 'a'
+template <class A, class B, class Less>
+int MergeCoRank(A a, int na, B b, int nb, int k, const Less& less)
+{
+    int lo = max(0, k - nb), hi = min(k, na);
+    while(lo < hi) {
+        int i = (lo + hi) >> 1;
+        if(less(b[k - i - 1], a[i]))
+            hi = i;
+        else
+            lo = i + 1;
+    }
+    return lo;
+}
+
+// Output elements [k0, k1) of the stable merge of a and b, moved to out + k0
+template <class A, class B, class O, class Less>
+void MergePiece(A a, int na, B b, int nb, O out, int k0, int k1, const Less& less)
+{
+    int i = MergeCoRank(a, na, b, nb, k0, less), j = k0 - i;
+    int ie = MergeCoRank(a, na, b, nb, k1, less), je = k1 - ie;
+    O o = out + k0;
+    while(i < ie && j < je)
+        *o++ = less(b[j], a[i]) ? pick(b[j++]) : pick(a[i++]);
+    while(i < ie)
+        *o++ = pick(a[i++]);
+    while(j < je)
+        *o++ = pick(b[j++]);
+}
+
+// Merges runs 0+1, 2+3... of 'src' into 'dst'; 'next' gets the bounds of the merged runs
+template <class S, class D, class Less>
+void MergeRound(S src, D dst, const Vector<int>& bound, Vector<int>& next, int grain, const Less& less)
+{
+    int runs = bound.GetCount() - 1;
+    next.Clear();
+    CoWork co;
+    for(int r = 0; r < runs; r += 2) {
+        int lo = bound[r];
+        next.Add(lo);
+        if(r + 1 == runs) { // odd run out, moved as it is
+            int hi = bound[r + 1];
+            for(int k = lo; k < hi; k += grain)
+                co & [=] {
+                    for(int i = k; i < min(k + grain, hi); i++)
+                        dst[i] = pick(src[i]);
+                };
+            break;
+        }
+        int mid = bound[r + 1], hi = bound[r + 2];
+        for(int k = lo; k < hi; k += grain) {
+            int k1 = min(k + grain, hi);
+            co & [=, &less] { MergePiece(src + lo, mid - lo, src + mid, hi - mid, dst + lo, k - lo, k1 - lo, less); };
+        }
+    }
+    next.Add(bound.Top());
+}
+
+template <class S, class D>
+void ParallelMove(S src, D dst, int n, int grain)
+{
+    CoWork co;
+    for(int k = 0; k < n; k += grain)
+        co & [=] {
+            for(int i = k; i < min(k + grain, n); i++)
+                dst[i] = pick(src[i]);
+        };
+}
+
+inline int ParallelSortThreads(int n)
+{
+    return clamp(n / PARALLEL_SORT_MIN, 1, CoWork::GetPoolSize() + 1);
+}
+
+template <class Range, class Less>
+void ParallelSort(Range&& r, const Less& less)
+{
+    typedef ValueTypeOf<Range> T;
+    int n = r.GetCount();
+    int threads = ParallelSortThreads(n);
+    if(threads < 2) {
+        Sort(r, less);
+        return;
+    }
+    auto data = r.begin();
+    Vector<int> bound, next;
+    for(int k = 0; k <= threads; k++)
+        bound.Add(int((int64)n * k / threads));
+    {
+        CoWork co;
+        for(int k = 0; k < threads; k++)
+            co & [=, &bound, &less] { Sort(SubRange(data + bound[k], data + bound[k + 1]), less); };
+    }
+    Buffer<T> tmp(n);
+    T *buf = tmp;
+    int grain = max(n / (4 * threads), 4096);
+    bool in_buf = false;
+    while(bound.GetCount() > 2) {
+        if(in_buf)
+            MergeRound(buf, data, bound, next, grain, less);
+        else
+            MergeRound(data, buf, bound, next, grain, less);
+        in_buf = !in_buf;
+        Swap(bound, next);
+    }
+    if(in_buf)
+        ParallelMove(buf, data, n, grain);
+}
+
+template <class Range>
+void ParallelSort(Range&& r)
+{
+    ParallelSort(r, std::less<ValueTypeOf<Range>>());
+}
+
+// Order preserving unsigned keys for RadixSort
+inline dword  RadixKey(int x)     { return dword(x) ^ 0x80000000; }
+inline dword  RadixKey(dword x)   { return x; }
+inline uint64 RadixKey(int64 x)   { return uint64(x) ^ ((uint64)1 << 63); }
+inline uint64 RadixKey(uint64 x)  { return x; }
+
+inline dword RadixKey(float x)
+{
+    dword u;
+    memcpy(&u, &x, sizeof(u));
+    return u & 0x80000000 ? ~u : u | 0x80000000; // negative numbers sort reversed
+}
+
+inline uint64 RadixKey(double x)
+{
+    uint64 u;
+    memcpy(&u, &x, sizeof(u));
+    return u & ((uint64)1 << 63) ? ~u : u | ((uint64)1 << 63);
+}
+
+// One 8 bit pass from src to dst; false (and nothing moved) if all keys share the digit
+template <class S, class D, class Key>
+bool RadixPass(S src, D dst, const Vector<int>& bound, int *count, int shift, const Key& key)
+{
+    int chunks = bound.GetCount() - 1;
+    auto histogram = [&](int c) {
+        int *h = count + 256 * c;
+        memset(h, 0, 256 * sizeof(int));
+        for(int i = bound[c]; i < bound[c + 1]; i++)
+            h[(key(src[i]) >> shift) & 255]++;
+    };
+    auto scatter = [&](int c) {
+        int *o = count + 256 * c;
+        for(int i = bound[c]; i < bound[c + 1]; i++) {
+            int d = (key(src[i]) >> shift) & 255;
+            dst[o[d]++] = pick(src[i]);
+        }
+    };
+    if(chunks > 1) {
+        CoWork co;
+        for(int c = 0; c < chunks; c++)
+            co & [&, c] { histogram(c); };
+    }
+    else
+        histogram(0);
+
+    int n = bound.Top();
+    for(int d = 0; d < 256; d++) {
+        int t = 0;
+        for(int c = 0; c < chunks; c++)
+            t += count[256 * c + d];
+        if(t == n)
+            return false;
+        if(t)
+            break;
+    }
+
+    // chunk c's elements of digit d go after those of the chunks before it: stable
+    int sum = 0;
+    for(int d = 0; d < 256; d++)
+        for(int c = 0; c < chunks; c++) {
+            int h = count[256 * c + d];
+            count[256 * c + d] = sum;
+            sum += h;
+        }
+
+    if(chunks > 1) {
+        CoWork co;
+        for(int c = 0; c < chunks; c++)
+            co & [&, c] { scatter(c); };
+    }
+    else
+        scatter(0);
+    return true;
+}
+
+template <class Range, class Key>
+void RadixSort(Range&& r, const Key& key)
+{
+    typedef ValueTypeOf<Range> T;
+    typedef decltype(key(*r.begin())) K;
+    int n = r.GetCount();
+    if(n < 2)
+        return;
+    auto data = r.begin();
+    int threads = ParallelSortThreads(n);
+    Vector<int> bound;
+    for(int k = 0; k <= threads; k++)
+        bound.Add(int((int64)n * k / threads));
+    Buffer<int> count(256 * threads);
+    Buffer<T> tmp(n);
+    T *buf = tmp;
+    bool in_buf = false;
+    for(int shift = 0; shift < 8 * (int)sizeof(K); shift += 8)
+        if(in_buf ? RadixPass(buf, data, bound, count, shift, key)
+                  : RadixPass(data, buf, bound, count, shift, key))
+            in_buf = !in_buf;
+    if(in_buf)
+        ParallelMove(buf, data, n, max(n / threads, 4096));
+}
+
+template <class Range>
+void RadixSort(Range&& r)
+{
+    RadixSort(r, [](const ValueTypeOf<Range>& x) { return RadixKey(x); });
+}
+
+// Index of the first s[i] == v for i in [from, n), -1 if there is none
+template <class T, class V>
+int FindEqualIn(const T *s, int from, int n, const V& v)
+{
+    for(int i = from; i < n; i++)
+        if(s[i] == v)
+            return i;
+    return -1;
+}
+
+#ifdef CPU_SSE2
+// 'eq' gives the byte mask of the elements equal to v in the 16 bytes at p
+template <class T, class Eq>
+int FindEqual16(const T *s, int from, int n, T v, Eq eq)
+{
+    enum { SIZE = sizeof(T), LANES = 16 / SIZE };
+    int i = from;
+    for(; i + 4 * LANES <= n; i += 4 * LANES) { // 64 bytes per test
+        dword m0 = eq(s + i), m1 = eq(s + i + LANES), m2 = eq(s + i + 2 * LANES), m3 = eq(s + i + 3 * LANES);
+        if(m0 | m1 | m2 | m3) {
+            if(m0) return i + CountTrailingZeroBits(m0) / SIZE;
+            if(m1) return i + LANES + CountTrailingZeroBits(m1) / SIZE;
+            if(m2) return i + 2 * LANES + CountTrailingZeroBits(m2) / SIZE;
+            return i + 3 * LANES + CountTrailingZeroBits(m3) / SIZE;
+        }
+    }
+    for(; i + LANES <= n; i += LANES)
+        if(dword m = eq(s + i))
+            return i + CountTrailingZeroBits(m) / SIZE;
+    return FindEqualIn(s, i, n, v);
+}
+
+inline __m128i SseLoad(const void *p) { return _mm_loadu_si128((const __m128i *)p); }
+
+inline int FindEqualIn(const byte *s, int from, int n, byte v)
+{
+    __m128i k = _mm_set1_epi8((char)v);
+    return FindEqual16(s, from, n, v, [&](const byte *p) { return (dword)_mm_movemask_epi8(_mm_cmpeq_epi8(SseLoad(p), k)); });
+}
+
+inline int FindEqualIn(const word *s, int from, int n, word v)
+{
+    __m128i k = _mm_set1_epi16((short)v);
+    return FindEqual16(s, from, n, v, [&](const word *p) { return (dword)_mm_movemask_epi8(_mm_cmpeq_epi16(SseLoad(p), k)); });
+}
+
+inline int FindEqualIn(const dword *s, int from, int n, dword v)
+{
+    __m128i k = _mm_set1_epi32((int)v);
+    return FindEqual16(s, from, n, v, [&](const dword *p) { return (dword)_mm_movemask_epi8(_mm_cmpeq_epi32(SseLoad(p), k)); });
+}
+
+inline int FindEqualIn(const uint64 *s, int from, int n, uint64 v)
+{
+    __m128i k = _mm_set_epi32(int(v >> 32), int(v), int(v >> 32), int(v));
+    return FindEqual16(s, from, n, v, [&](const uint64 *p) {
+        __m128i c = _mm_cmpeq_epi32(SseLoad(p), k); // SSE2 has no 64 bit compare: both halves equal
+        return (dword)_mm_movemask_epi8(_mm_and_si128(c, _mm_shuffle_epi32(c, _MM_SHUFFLE(2, 3, 0, 1))));
+    });
+}
+
+inline int FindEqualIn(const float *s, int from, int n, float v)
+{
+    __m128 k = _mm_set1_ps(v);
+    return FindEqual16(s, from, n, v, [&](const float *p) {
+        return (dword)_mm_movemask_epi8(_mm_castps_si128(_mm_cmpeq_ps(_mm_loadu_ps(p), k)));
+    });
+}
+
+inline int FindEqualIn(const double *s, int from, int n, double v)
+{
+    __m128d k = _mm_set1_pd(v);
+    return FindEqual16(s, from, n, v, [&](const double *p) {
+        return (dword)_mm_movemask_epi8(_mm_castpd_si128(_mm_cmpeq_pd(_mm_loadu_pd(p), k)));
+    });
+}
+
+// Signed integers compare bit for bit like their unsigned twins
+inline int FindEqualIn(const char *s, int from, int n, char v)     { return FindEqualIn((const byte *)s, from, n, (byte)v); }
+inline int FindEqualIn(const int8 *s, int from, int n, int8 v)     { return FindEqualIn((const byte *)s, from, n, (byte)v); }
+inline int FindEqualIn(const int16 *s, int from, int n, int16 v)   { return FindEqualIn((const word *)s, from, n, (word)v); }
+inline int FindEqualIn(const int *s, int from, int n, int v)       { return FindEqualIn((const dword *)s, from, n, (dword)v); }
+inline int FindEqualIn(const int64 *s, int from, int n, int64 v)   { return FindEqualIn((const uint64 *)s, from, n, (uint64)v); }
+#endif
+
+// FindIndex compares s[i] == value in the common type C of the element type T and V. That
+// is an SSE2 compare with a single T needle only when T converts to C without merging
+// values (not so for int64 against double, or int against float)
+template <class T, class V>
+constexpr bool FastFindSimd()
+{
+    if constexpr(std::is_arithmetic<T>::value && std::is_arithmetic<V>::value) {
+        typedef std::common_type_t<T, V> C;
+        return !std::is_floating_point<C>::value || std::is_floating_point<T>::value ||
+               std::numeric_limits<T>::digits <= std::numeric_limits<C>::digits;
+    }
+    return false;
+}
+
+// The T that equals value in C; false when no T does (NaN, out of range, fraction)
+template <class T, class V>
+bool FastFindNeedle(const V& value, T& needle)
+{
+    typedef std::common_type_t<T, V> C;
+    C c = (C)value;
+    if constexpr(std::is_floating_point<C>::value) {
+        if(std::isnan(c))
+            return false;
+        if constexpr(std::is_integral<T>::value) {
+            if(c < (C)std::numeric_limits<T>::min() || c > (C)std::numeric_limits<T>::max())
+                return false;
+        }
+        else
+        if(std::isfinite(c) && std::abs(c) > (C)std::numeric_limits<T>::max())
+            return false;
+    }
+    needle = (T)c;
+    return (C)needle == c;
+}
+
+template <class Range, class V>
+int FastFindIndex(const Range& r, const V& value, int from = 0)
+{
+    typedef typename std::remove_const<ValueTypeOf<Range>>::type T;
+    auto s = r.begin();
+    int n = r.GetCount();
+    if constexpr(FastFindSimd<T, V>() && std::is_pointer<decltype(s)>::value) {
+        T needle;
+        if(!FastFindNeedle(value, needle))
+            return -1;
+        return FindEqualIn((const T *)s, max(from, 0), n, needle);
+    }
+    else {
+        for(int i = max(from, 0); i < n; i++)
+            if(s[i] == value)
+                return i;
+        return -1;
+    }
+}
+
+#endif